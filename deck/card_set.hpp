@@ -0,0 +1,271 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <random>
+
+enum class Suit : std::uint8_t { Clubs, Diamonds, Hearts, Spades };
+
+enum class Rank : std::uint8_t {
+  Two,
+  Three,
+  Four,
+  Five,
+  Six,
+  Seven,
+  Eight,
+  Nine,
+  Ten,
+  Jack,
+  Queen,
+  King,
+  Ace
+};
+
+/*! \brief A standard playing card packed in one byte, so a RingDeck<Card>
+ *  stores one byte per card.
+ *  The index is suit * 16 + rank, so every suit owns a 16 bit lane of a
+ *  CardSet mask.
+ */
+class Card {
+public:
+  /*! \brief The two of clubs */
+  constexpr Card() noexcept = default;
+  constexpr Card(Rank rank, Suit suit) noexcept
+      : m_index(static_cast<std::uint8_t>(static_cast<unsigned>(suit) * 16 +
+                                          static_cast<unsigned>(rank))) {}
+
+  constexpr Rank rank() const noexcept {
+    return static_cast<Rank>(m_index & 0xfu);
+  }
+  constexpr Suit suit() const noexcept {
+    return static_cast<Suit>(m_index >> 4u);
+  }
+  /*! \brief position of the card in a CardSet mask, below 64 */
+  constexpr std::uint8_t index() const noexcept { return m_index; }
+
+  constexpr bool operator==(const Card &rhs) const noexcept = default;
+
+private:
+  // only a CardSet hands out indices, so every index is a valid card below 64
+  friend class CardSet;
+
+  constexpr explicit Card(std::uint8_t index) noexcept : m_index(index) {}
+
+  /*! \brief Card with the given index, \see index() */
+  static constexpr Card from_index(std::uint8_t index) noexcept {
+    return Card{index};
+  }
+
+  std::uint8_t m_index = 0;
+};
+
+/*! \brief Set of cards as a 64 bit mask. Membership, insertion and removal
+ *  are single bit operations, counting is a popcount, and set algebra works
+ *  on the whole mask at once.
+ */
+class CardSet {
+public:
+  /*! \brief Iterates the cards of the set in index order */
+  class iterator {
+  public:
+    typedef std::input_iterator_tag iterator_category;
+    typedef std::forward_iterator_tag iterator_concept;
+    typedef Card value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const Card *pointer;
+    typedef Card reference;
+
+    iterator() noexcept = default;
+    explicit iterator(std::uint64_t mask) noexcept : m_mask(mask) {}
+
+    Card operator*() const noexcept {
+      return Card::from_index(
+          static_cast<std::uint8_t>(std::countr_zero(m_mask)));
+    }
+    iterator &operator++() noexcept {
+      m_mask &= m_mask - 1; // clear the lowest card
+      return *this;
+    }
+    iterator operator++(int) noexcept {
+      auto it = *this;
+      ++*this;
+      return it;
+    }
+    bool operator==(const iterator &rhs) const noexcept = default;
+
+  private:
+    std::uint64_t m_mask = 0;
+  };
+
+public:
+  /*! \brief Creates an empty set */
+  constexpr CardSet() noexcept = default;
+  constexpr explicit CardSet(std::uint64_t mask) noexcept : m_mask(mask) {}
+
+  /*! \brief All 52 cards */
+  static constexpr CardSet full() noexcept {
+    return CardSet{kSuitMask * 0x0001000100010001ULL};
+  }
+  /*! \brief The 13 cards of `suit` */
+  static constexpr CardSet of_suit(Suit suit) noexcept {
+    return CardSet{kSuitMask << (16u * static_cast<unsigned>(suit))};
+  }
+
+  constexpr bool contains(Card card) const noexcept {
+    return (m_mask >> card.index()) & 1u;
+  }
+  constexpr void insert(Card card) noexcept { m_mask |= bit(card); }
+  constexpr void remove(Card card) noexcept { m_mask &= ~bit(card); }
+
+  constexpr std::size_t size() const noexcept {
+    return static_cast<std::size_t>(std::popcount(m_mask));
+  }
+  constexpr bool empty() const noexcept { return m_mask == 0; }
+  constexpr std::uint64_t mask() const noexcept { return m_mask; }
+
+  /*! \brief The ranks held in `suit`, bit n set for Rank n */
+  constexpr std::uint16_t ranks(Suit suit) const noexcept {
+    return static_cast<std::uint16_t>(m_mask >>
+                                      (16u * static_cast<unsigned>(suit)));
+  }
+
+  iterator begin() const noexcept { return iterator{m_mask}; }
+  iterator end() const noexcept { return iterator{}; }
+
+  constexpr CardSet operator|(CardSet rhs) const noexcept {
+    return CardSet{m_mask | rhs.m_mask};
+  }
+  constexpr CardSet operator&(CardSet rhs) const noexcept {
+    return CardSet{m_mask & rhs.m_mask};
+  }
+  /*! \brief cards of this set that are not in `rhs` */
+  constexpr CardSet operator-(CardSet rhs) const noexcept {
+    return CardSet{m_mask & ~rhs.m_mask};
+  }
+  constexpr bool operator==(const CardSet &rhs) const noexcept = default;
+
+private:
+  static constexpr std::uint64_t kSuitMask = (1u << 13u) - 1;
+
+  static constexpr std::uint64_t bit(Card card) noexcept {
+    return std::uint64_t{1} << card.index();
+  }
+
+  std::uint64_t m_mask = 0;
+};
+
+/*! \brief Deck of up to 52 distinct cards: one byte per card for the order,
+ *  and a CardSet for membership, so contains() and counting never scan.
+ */
+class PackedDeck {
+  typedef std::array<Card, 52> cards_t;
+
+public:
+  // the top card is stored last, so add and draw work at the end
+  typedef std::reverse_iterator<cards_t::const_iterator> const_iterator_t;
+
+public:
+  /*! \brief Creates an empty deck */
+  PackedDeck() noexcept = default;
+
+  /*! \brief All 52 cards, by suit and rank from the top */
+  static PackedDeck full() noexcept {
+    PackedDeck deck;
+    for (const Card card : CardSet::full()) {
+      deck.m_cards[deck.m_cards.size() - ++deck.m_size] = card;
+    }
+    deck.m_set = CardSet::full();
+    return deck;
+  }
+
+  const_iterator_t cbegin() const noexcept {
+    return const_iterator_t{m_cards.cbegin() + m_size};
+  }
+  const_iterator_t cend() const noexcept {
+    return const_iterator_t{m_cards.cbegin()};
+  }
+
+  bool operator==(const PackedDeck &rhs) const noexcept {
+    return std::equal(cbegin(), cend(), rhs.cbegin(), rhs.cend());
+  }
+
+  std::size_t size() const noexcept { return m_size; }
+  bool empty() const noexcept { return m_size == 0; }
+
+  /*! \brief The cards in the deck */
+  CardSet cards() const noexcept { return m_set; }
+  bool contains(Card card) const noexcept { return m_set.contains(card); }
+
+  /*! \brief Returns the value of the top card in the deck */
+  std::optional<Card> top() const noexcept {
+    if (m_size == 0) {
+      return std::nullopt;
+    }
+    return m_cards[m_size - 1];
+  }
+
+  /*! \brief Returns the value of the bottom card in the deck */
+  std::optional<Card> bottom() const noexcept {
+    if (m_size == 0) {
+      return std::nullopt;
+    }
+    return m_cards[0];
+  }
+
+  /*! \brief Removes the top card of the deck, and retrieves it */
+  std::optional<Card> draw() noexcept {
+    if (m_size == 0) {
+      return std::nullopt;
+    }
+    const Card card = m_cards[--m_size];
+    m_set.remove(card);
+    return card;
+  }
+
+  /*! \brief Adds a card on the top of the deck
+   *  \return false if the card is already in the deck
+   */
+  bool add(Card card) noexcept {
+    if (m_set.contains(card)) {
+      return false;
+    }
+    m_cards[m_size++] = card;
+    m_set.insert(card);
+    return true;
+  }
+
+  /*! \brief Takes `card` out of the deck, wherever it is.
+   *  Shifts at most 51 bytes, and nothing if the card is not in the deck.
+   *  \return false if the card is not in the deck
+   */
+  bool remove(Card card) noexcept {
+    if (!m_set.contains(card)) {
+      return false;
+    }
+    const auto end = m_cards.begin() + m_size;
+    const auto it = std::find(m_cards.begin(), end, card);
+    std::copy(std::next(it), end, it);
+    --m_size;
+    m_set.remove(card);
+    return true;
+  }
+
+  /*! \brief shuffle the order of the cards in the deck
+   *  \param gen(optional) seed for the shuffle
+   */
+  template <typename Gen = std::mt19937>
+    requires std::uniform_random_bit_generator<std::remove_reference_t<Gen>>
+  void shuffle(Gen gen = std::mt19937{std::random_device{}()}) {
+    std::shuffle(m_cards.begin(), m_cards.begin() + m_size, gen);
+  }
+
+private:
+  cards_t m_cards{};
+  std::size_t m_size = 0;
+  CardSet m_set;
+};
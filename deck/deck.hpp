@@ -4,12 +4,22 @@
 #include <iterator>
 #include <optional>
 #include <random>
+#include <ranges>
+#include <utility>
+#include <vector>
 
-template <typename C> class Deck {
+#include "ring_buffer.hpp"
+
+/*! \brief A deck of cards of type `C`
+ *  \param Storage sequence holding the cards, top card first. Needs
+ *  random access iterators, front/back, push_front/pop_front,
+ *  size/max_size/empty, erase and swap, e.g. std::deque or RingBuffer.
+ */
+template <typename C, typename Storage = std::deque<C>> class Deck {
   /* Container requirements */
 public:
-  typedef std::deque<C>::iterator iterator_t;
-  typedef std::deque<C>::const_iterator const_iterator_t;
+  typedef Storage::iterator iterator_t;
+  typedef Storage::const_iterator const_iterator_t;
 
   /* Container requirements */
 public:
@@ -78,24 +88,85 @@ public:
     if (m_cards.size() == 0) {
       return std::nullopt;
     } else {
-      const auto card = std::make_optional<C>(m_cards.front());
+      auto card = std::make_optional<C>(std::move(m_cards.front()));
       m_cards.pop_front();
       return card;
     }
   }
 
+  /*! \brief Removes up to `n` cards from the top of the deck, and moves them
+   *  to `out`, top card first
+   *  \return iterator past the last card written
+   */
+  template <typename OutputIt>
+    requires std::output_iterator<OutputIt, C &&>
+  OutputIt draw_n(std::size_t n, OutputIt out) {
+    const auto count = std::min(n, m_cards.size());
+    auto cards = contiguous();
+    out = std::move(cards.begin(), cards.begin() + count, out);
+    m_cards.erase(m_cards.begin(), m_cards.begin() + count);
+    return out;
+  }
+
+  /*! \brief Removes `n_each` cards from the top of the deck for each of
+   *  `k_hands` hands. Each hand takes a consecutive block of cards; for a
+   *  shuffled deck this is as random as dealing them one by one.
+   *  \return the hands, or nothing if the deck holds too few cards
+   */
+  std::optional<std::vector<std::vector<C>>> deal(std::size_t k_hands,
+                                                  std::size_t n_each) {
+    std::vector<std::vector<C>> hands;
+    // k_hands * n_each > size(), without overflowing the product; empty
+    // hands take no cards, but there may be too many for a vector
+    if (n_each == 0 ? k_hands > hands.max_size()
+                    : k_hands > m_cards.size() / n_each) {
+      return std::nullopt;
+    }
+    const auto count = k_hands * n_each;
+    hands.resize(k_hands);
+    auto cards = contiguous();
+    auto first = cards.begin();
+    for (auto &hand : hands) {
+      hand.assign(std::make_move_iterator(first),
+                  std::make_move_iterator(first + n_each));
+      first += n_each;
+    }
+    m_cards.erase(m_cards.begin(), m_cards.begin() + count);
+    return hands;
+  }
+
   /*! \brief Adds a card on the top of the deck */
-  void add(C card) noexcept { m_cards.push_front(card); }
+  void add(const C &card) noexcept { m_cards.push_front(card); }
+  /*! \brief Moves a card on the top of the deck */
+  void add(C &&card) noexcept { m_cards.push_front(std::move(card)); }
+  /*! \brief Constructs a card on the top of the deck */
+  template <typename... Args> C &emplace(Args &&...args) {
+    return m_cards.emplace_front(std::forward<Args>(args)...);
+  }
 
   /*! \brief shuffle the order of the cards in the deck
    *  \param gen(optional) seed for the shuffle
    */
-  template <typename Gen>
+  template <typename Gen = std::mt19937>
     requires std::uniform_random_bit_generator<std::remove_reference_t<Gen>>
   void shuffle(Gen gen = std::mt19937{std::random_device{}()}) {
-    std::ranges::shuffle(m_cards, gen);
+    std::ranges::shuffle(contiguous(), gen);
   }
 
 private:
-  std::deque<C> m_cards;
+  /*! \brief The cards, top card first, as one contiguous block if the
+   *  storage supports it, so algorithms work on plain pointers
+   */
+  auto contiguous() {
+    if constexpr (requires { m_cards.linearize(); }) {
+      return m_cards.linearize();
+    } else {
+      return std::ranges::subrange(m_cards.begin(), m_cards.end());
+    }
+  }
+
+  Storage m_cards;
 };
+
+/*! \brief Deck stored in a contiguous ring buffer */
+template <typename C> using RingDeck = Deck<C, RingBuffer<C>>;
@@ -0,0 +1,61 @@
+#include "deck.hpp"
+#include "shuffle_engine.hpp"
+#include <chrono>
+#include <cstdio>
+#include <span>
+#include <thread>
+#include <vector>
+
+// Shuffle throughput benchmark: decks of 52 cards shuffled per second by
+// Deck::shuffle with its default generator, and by the ShuffleEngine for an
+// increasing number of threads. Built with optimisations, see CMakeLists.txt.
+
+template <typename F> static double secondsFor(F &&f) {
+  const auto start = std::chrono::steady_clock::now();
+  f();
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+template <typename DeckT> static std::vector<DeckT> makeDecks(std::size_t n) {
+  DeckT deck;
+  for (int i = 52; i > 0; i--) {
+    deck.add(i);
+  }
+  return std::vector<DeckT>(n, deck);
+}
+
+template <typename DeckT> static void benchmark(const char *name) {
+  constexpr std::size_t kDecks = 100'000;
+  constexpr int kRounds = 10;
+  auto decks = makeDecks<DeckT>(kDecks);
+
+  const double default_s = secondsFor([&] {
+    for (auto &deck : decks) {
+      deck.shuffle();
+    }
+  });
+  std::printf("%-10s %-22s %14.0f\n", name, "Deck::shuffle()",
+              kDecks / default_s);
+
+  const unsigned max_threads =
+      std::max(1u, std::thread::hardware_concurrency());
+  for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+    ShuffleEngine engine{5544, threads};
+    const double engine_s = secondsFor([&] {
+      for (int round = 0; round < kRounds; ++round) {
+        engine.shuffle(std::span{decks});
+      }
+    });
+    std::printf("%-10s ShuffleEngine %2u thr.  %14.0f\n", name, threads,
+                kRounds * kDecks / engine_s);
+  }
+}
+
+int main() {
+  std::printf("%-10s %-22s %14s\n", "storage", "shuffle", "decks/s");
+  benchmark<Deck<int>>("deque");
+  benchmark<RingDeck<int>>("ring");
+  return 0;
+}
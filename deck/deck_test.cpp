@@ -1,7 +1,17 @@
+#include "card_set.hpp"
 #include "deck.hpp"
+#include "shuffle_engine.hpp"
+#include <array>
+#include <bit>
+#include <deque>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
 #include <gtest/gtest.h>
 
-class DeckTestInt : public ::testing::Test {
+template <typename DeckT> class DeckTestInt : public ::testing::Test {
 protected:
   void SetUp() override {
     d1_.add(4);
@@ -11,7 +21,7 @@ protected:
 
   void TearDown() override {}
 
-  typedef Deck<int> deck_t;
+  typedef DeckT deck_t;
   // 0 elements deck
   deck_t d0_;
   // 1 element deck
@@ -21,157 +31,495 @@ protected:
   std::mt19937 gen_{/* seed */ 5544};
 };
 
-TEST_F(DeckTestInt, ContainerReqConstructorEmptyParam) {
-  deck_t d{};
+// every test runs for each storage backend
+typedef ::testing::Types<Deck<int>, RingDeck<int>> DeckTypes;
+TYPED_TEST_SUITE(DeckTestInt, DeckTypes);
+
+TYPED_TEST(DeckTestInt, ContainerReqConstructorEmptyParam) {
+  typename TestFixture::deck_t d{};
   EXPECT_TRUE(d.empty());
 }
 
-TEST_F(DeckTestInt, ContainerReqConstructorCopyParamEq) {
-  EXPECT_EQ(d2_, deck_t{d2_});
+TYPED_TEST(DeckTestInt, ContainerReqConstructorCopyParamEq) {
+  EXPECT_EQ(this->d2_, typename TestFixture::deck_t{this->d2_});
 }
 
-TEST_F(DeckTestInt, ContainerReqConstructorMoveParamEq) {
-  auto d2_copy{d2_}; // FIXED AFTER SUBMISSION
-  EXPECT_EQ(d2_copy, deck_t{std::move(d2_)});
-  EXPECT_TRUE(d2_.empty());
+TYPED_TEST(DeckTestInt, ContainerReqConstructorMoveParamEq) {
+  auto d2_copy{this->d2_}; // FIXED AFTER SUBMISSION
+  EXPECT_EQ(d2_copy, typename TestFixture::deck_t{std::move(this->d2_)});
+  EXPECT_TRUE(this->d2_.empty());
 }
 
-TEST_F(DeckTestInt, ContainerReqAssignCopyParamEq) {
-  deck_t d2_copy;
-  EXPECT_EQ(d2_, d2_copy = d2_);
+TYPED_TEST(DeckTestInt, ContainerReqAssignCopyParamEq) {
+  typename TestFixture::deck_t d2_copy;
+  EXPECT_EQ(this->d2_, d2_copy = this->d2_);
 }
 
-TEST_F(DeckTestInt, ContainerReqMoveParamEq) {
-  deck_t d2_new;
-  EXPECT_NE(d2_, d2_new = std::move(d2_));
-  EXPECT_EQ(d2_.size(), 0);
+TYPED_TEST(DeckTestInt, ContainerReqMoveParamEq) {
+  typename TestFixture::deck_t d2_new;
+  EXPECT_NE(this->d2_, d2_new = std::move(this->d2_));
+  EXPECT_EQ(this->d2_.size(), 0);
 }
 
-TEST_F(DeckTestInt, ContainerReqIterators) {
-  auto deck{d2_};
+TYPED_TEST(DeckTestInt, ContainerReqIterators) {
+  auto deck{this->d2_};
   EXPECT_EQ(deck.cend() - deck.cbegin(), deck.size());
   EXPECT_EQ(*deck.cbegin(), deck.top());
   EXPECT_EQ(*(deck.cend() - 1), deck.bottom());
 }
 
-TEST_F(DeckTestInt, ContainerReqSwapStatic) {
-  auto d1_copy{d1_};
-  auto d2_copy{d2_};
+TYPED_TEST(DeckTestInt, ContainerReqSwapStatic) {
+  auto d1_copy{this->d1_};
+  auto d2_copy{this->d2_};
 
-  d1_.swap(d2_);
+  this->d1_.swap(this->d2_);
 
-  EXPECT_EQ(d1_.size(), d2_copy.size());
-  EXPECT_EQ(d2_.size(), d1_copy.size());
-  EXPECT_EQ(d1_, d2_copy);
-  EXPECT_EQ(d2_, d1_copy);
+  EXPECT_EQ(this->d1_.size(), d2_copy.size());
+  EXPECT_EQ(this->d2_.size(), d1_copy.size());
+  EXPECT_EQ(this->d1_, d2_copy);
+  EXPECT_EQ(this->d2_, d1_copy);
 }
 
-TEST_F(DeckTestInt, ContainerReqSwapThis) {
-  auto d1_copy{d1_};
-  auto d2_copy{d2_};
+TYPED_TEST(DeckTestInt, ContainerReqSwapThis) {
+  auto d1_copy{this->d1_};
+  auto d2_copy{this->d2_};
 
-  deck_t::swap(d1_, d2_);
+  TestFixture::deck_t::swap(this->d1_, this->d2_);
 
-  EXPECT_EQ(d1_.size(), d2_copy.size());
-  EXPECT_EQ(d2_.size(), d1_copy.size());
-  EXPECT_EQ(d1_, d2_copy);
-  EXPECT_EQ(d2_, d1_copy);
+  EXPECT_EQ(this->d1_.size(), d2_copy.size());
+  EXPECT_EQ(this->d2_.size(), d1_copy.size());
+  EXPECT_EQ(this->d1_, d2_copy);
+  EXPECT_EQ(this->d2_, d1_copy);
 }
 
-TEST_F(DeckTestInt, ContainerReqSize) {
-  EXPECT_EQ(0, d0_.size());
-  EXPECT_EQ(2, d2_.size());
+TYPED_TEST(DeckTestInt, ContainerReqSize) {
+  EXPECT_EQ(0, this->d0_.size());
+  EXPECT_EQ(2, this->d2_.size());
 }
 
-TEST_F(DeckTestInt, ContainerReqMaxSize) {
+TYPED_TEST(DeckTestInt, ContainerReqMaxSize) {
   // expect a large number, in runtime depends on memory available
-  EXPECT_GT(d0_.max_size(), 100'000'000);
+  EXPECT_GT(this->d0_.max_size(), 100'000'000);
 }
 
-TEST_F(DeckTestInt, ContainerReqEmpty) { EXPECT_TRUE(d0_.empty()); }
+TYPED_TEST(DeckTestInt, ContainerReqEmpty) { EXPECT_TRUE(this->d0_.empty()); }
 
-TEST_F(DeckTestInt, ContainerReqNonEmpty) { EXPECT_FALSE(d1_.empty()); }
+TYPED_TEST(DeckTestInt, ContainerReqNonEmpty) { EXPECT_FALSE(this->d1_.empty()); }
 
-TEST_F(DeckTestInt, PropertyTopOfEmptyDeck) {
-  auto &deck{d0_};
+TYPED_TEST(DeckTestInt, PropertyTopOfEmptyDeck) {
+  auto &deck{this->d0_};
 
   EXPECT_FALSE(deck.top().has_value());
 }
 
-TEST_F(DeckTestInt, PropertyTopOfDeckWorks) {
+TYPED_TEST(DeckTestInt, PropertyTopOfDeckWorks) {
   const auto card{0}; // was inserted last, therefore shall be top
-  auto &deck{d2_};
+  auto &deck{this->d2_};
 
   EXPECT_EQ(card, deck.top().value());
 }
 
-TEST_F(DeckTestInt, PropertyBottomOfEmptyDeck) {
-  auto &deck{d0_};
+TYPED_TEST(DeckTestInt, PropertyBottomOfEmptyDeck) {
+  auto &deck{this->d0_};
 
   EXPECT_FALSE(deck.top().has_value());
 }
 
-TEST_F(DeckTestInt, PropertyBottomOfDeckWorks) {
+TYPED_TEST(DeckTestInt, PropertyBottomOfDeckWorks) {
   const auto card{2}; // was inserted first, therefore shall be bottom
-  auto &deck{d2_};
+  auto &deck{this->d2_};
 
   EXPECT_EQ(card, deck.bottom().value());
 }
 
-TEST_F(DeckTestInt, PropertyDrawEmpty) {
-  auto &deck{d0_};
+TYPED_TEST(DeckTestInt, PropertyDrawEmpty) {
+  auto &deck{this->d0_};
 
   EXPECT_FALSE(deck.draw().has_value());
 }
 
-TEST_F(DeckTestInt, PropertyDrawOfSingleDeckEmpties) {
-  auto &deck{d1_};
+TYPED_TEST(DeckTestInt, PropertyDrawOfSingleDeckEmpties) {
+  auto &deck{this->d1_};
 
   EXPECT_EQ(1, deck.size());
   deck.draw();
   EXPECT_EQ(0, deck.size());
 }
 
-TEST_F(DeckTestInt, PropertyDrawFromLargeDeckWorks) {
+TYPED_TEST(DeckTestInt, PropertyDrawFromLargeDeckWorks) {
   const auto card{0};
-  auto &deck{d2_};
+  auto &deck{this->d2_};
 
   EXPECT_EQ(card, deck.top().value());
   deck.draw();
   EXPECT_NE(card, deck.top().value());
 }
 
-TEST_F(DeckTestInt, PropertyAddEmptyDeck) {
+TYPED_TEST(DeckTestInt, PropertyAddEmptyDeck) {
   const auto card{5};
-  auto &deck{d0_};
+  auto &deck{this->d0_};
 
   deck.add(card);
   EXPECT_EQ(card, deck.top().value());
 }
 
-TEST_F(DeckTestInt, PropertyAddPrepends) {
+TYPED_TEST(DeckTestInt, PropertyAddPrepends) {
   const auto card{5};
-  auto &deck{d2_};
+  auto &deck{this->d2_};
 
   EXPECT_NE(card, deck.top().value());
   deck.add(card);
   EXPECT_EQ(card, deck.top().value());
 }
 
-TEST_F(DeckTestInt, PropertyShuffleEmpty) {
-  auto &deck{d0_};
+TYPED_TEST(DeckTestInt, PropertyShuffleEmpty) {
+  auto &deck{this->d0_};
 
-  EXPECT_NO_THROW(deck.shuffle(gen_));
+  EXPECT_NO_THROW(deck.shuffle(this->gen_));
 }
 
-TEST_F(DeckTestInt, PropertyShuffleRemovesOrder) {
-  auto &deck{d0_};
+TYPED_TEST(DeckTestInt, PropertyShuffleRemovesOrder) {
+  auto &deck{this->d0_};
 
   for (int i = 52; i > 0; i--) {
     deck.add(i);
   }
-  const auto prev_deck_order{d0_}; // a copy
+  const auto prev_deck_order{this->d0_}; // a copy
   EXPECT_EQ(prev_deck_order, deck);
-  deck.shuffle(gen_);
+  deck.shuffle(this->gen_);
   EXPECT_NE(prev_deck_order, deck);
-}
\ No newline at end of file
+}
+TYPED_TEST(DeckTestInt, PropertyShuffleDefaultGenerator) {
+  auto &deck{this->d2_};
+
+  EXPECT_NO_THROW(deck.shuffle());
+  EXPECT_EQ(2, deck.size());
+}
+
+TYPED_TEST(DeckTestInt, PropertyDrawNTakesTopCardsInOrder) {
+  auto &deck{this->d0_};
+  for (int i = 10; i > 0; i--) {
+    deck.add(i);
+  }
+
+  std::vector<int> cards;
+  deck.draw_n(3, std::back_inserter(cards));
+  EXPECT_EQ(cards, (std::vector<int>{1, 2, 3}));
+  EXPECT_EQ(7, deck.size());
+  EXPECT_EQ(4, deck.top().value());
+}
+
+TYPED_TEST(DeckTestInt, PropertyDrawNMoreThanSize) {
+  auto &deck{this->d2_};
+
+  int cards[4]{};
+  const auto out = deck.draw_n(4, cards);
+  EXPECT_EQ(2, out - cards);
+  EXPECT_EQ(0, cards[0]);
+  EXPECT_EQ(2, cards[1]);
+  EXPECT_TRUE(deck.empty());
+}
+
+TYPED_TEST(DeckTestInt, PropertyDealHands) {
+  auto &deck{this->d0_};
+  for (int i = 52; i > 0; i--) {
+    deck.add(i);
+  }
+  deck.shuffle(this->gen_);
+  const auto shuffled{deck}; // a copy
+
+  const auto hands = deck.deal(4, 13);
+  ASSERT_TRUE(hands.has_value());
+  EXPECT_EQ(4, hands->size());
+  EXPECT_TRUE(deck.empty());
+  auto card = shuffled.cbegin();
+  for (const auto &hand : *hands) {
+    EXPECT_EQ(13, hand.size());
+    EXPECT_TRUE(std::equal(hand.begin(), hand.end(), card));
+    card += 13;
+  }
+}
+
+TYPED_TEST(DeckTestInt, PropertyDealTooFewCards) {
+  auto &deck{this->d2_};
+
+  EXPECT_FALSE(deck.deal(3, 1).has_value());
+  // k_hands * n_each overflows to 0
+  EXPECT_FALSE(deck.deal(std::numeric_limits<std::size_t>::max() / 2 + 1, 2).has_value());
+  // no cards, but more hands than a vector holds
+  EXPECT_FALSE(deck.deal(std::numeric_limits<std::size_t>::max(), 0).has_value());
+  EXPECT_EQ(3, deck.deal(3, 0)->size());
+  EXPECT_EQ(2, deck.size());
+  EXPECT_EQ(1, deck.deal(2, 1)->front().size());
+  EXPECT_TRUE(deck.empty());
+}
+
+TYPED_TEST(DeckTestInt, PropertyEmplaceAddsOnTop) {
+  auto &deck{this->d2_};
+
+  EXPECT_EQ(7, deck.emplace(7));
+  EXPECT_EQ(7, deck.top().value());
+  EXPECT_EQ(3, deck.size());
+}
+
+TEST(DeckString, PropertyAddMovesCard) {
+  Deck<std::string> deck;
+  std::string card(64, 'K');
+  const auto *chars = card.data();
+
+  deck.add(std::move(card));
+  EXPECT_EQ(chars, deck.begin()->data()); // not copied
+  EXPECT_EQ(chars, deck.draw()->data());
+}
+
+TEST(RingBufferInt, EraseFromTheMiddle) {
+  RingBuffer<int> ring;
+  for (int i = 5; i > 0; i--) {
+    ring.push_front(i);
+  }
+  ring.erase(ring.begin() + 1, ring.begin() + 3);
+  EXPECT_EQ(std::vector<int>(ring.begin(), ring.end()),
+            (std::vector<int>{1, 4, 5}));
+}
+
+// the elements wrap around the end of the buffer
+template <typename T> bool is_wrapped(const RingBuffer<T> &ring) {
+  return !ring.empty() && &ring.back() < &ring.front();
+}
+
+TEST(RingBufferInt, WrapsAroundAndGrowsInOrder) {
+  RingBuffer<int> ring;
+  std::deque<int> reference;
+  bool wrapped = false;
+  for (int i = 0; i < 100; ++i) {
+    ring.push_front(i);
+    reference.push_front(i);
+    if (i % 3 == 0) { // pop now and then, so the head moves both ways
+      ring.pop_front();
+      reference.pop_front();
+    }
+    if (i % 7 == 6) { // erasing in the middle frees slots at the end, so
+                      // the following push_front calls wrap around
+      ring.erase(ring.begin() + 1, ring.begin() + 2);
+      reference.erase(reference.begin() + 1, reference.begin() + 2);
+    }
+    wrapped = wrapped || is_wrapped(ring);
+    ASSERT_TRUE(std::equal(ring.begin(), ring.end(), reference.begin(),
+                           reference.end()));
+  }
+  EXPECT_TRUE(wrapped);
+  EXPECT_EQ(ring.front(), reference.front());
+  EXPECT_EQ(ring.back(), reference.back());
+  EXPECT_EQ(std::popcount(ring.capacity()), 1);
+}
+
+TEST(RingBufferInt, PushFrontAnElementOfAFullRing) {
+  RingBuffer<std::string> ring;
+  for (int i = 0; i < 8; ++i) {
+    ring.push_front(std::string(32, static_cast<char>('a' + i)));
+  }
+  ASSERT_EQ(ring.size(), ring.capacity());
+  ring.push_front(ring.back()); // grows while reading the old buffer
+  ring.push_front(ring.begin()[1]);
+  EXPECT_EQ(ring.size(), 10u);
+  EXPECT_EQ(ring.front(), std::string(32, 'h'));
+  EXPECT_EQ(ring.begin()[1], std::string(32, 'a'));
+  EXPECT_EQ(ring.begin()[2], std::string(32, 'h'));
+  EXPECT_EQ(ring.back(), std::string(32, 'a'));
+}
+
+// counts the live instances, and throws from the copy constructor when
+// `copies_left` reaches 0; the move constructor may throw, so RingBuffer
+// copies it
+struct ThrowingCopy {
+  static inline int live = 0;
+  static inline int copies_left = -1;
+
+  int value;
+  explicit ThrowingCopy(int v) : value(v) { ++live; }
+  ThrowingCopy(const ThrowingCopy &rhs) : value(rhs.value) {
+    if (copies_left-- == 0) {
+      throw std::runtime_error("copy");
+    }
+    ++live;
+  }
+  ThrowingCopy(ThrowingCopy &&rhs) : ThrowingCopy(rhs) {}
+  ~ThrowingCopy() { --live; }
+};
+
+TEST(RingBufferInt, ThrowingCopyLeavesNothingBehind) {
+  {
+    RingBuffer<ThrowingCopy> ring;
+    for (int i = 0; i < 8; ++i) {
+      ring.emplace_front(i);
+    }
+    ThrowingCopy::copies_left = 4;
+    EXPECT_THROW(RingBuffer<ThrowingCopy>{ring}, std::runtime_error);
+    EXPECT_EQ(ThrowingCopy::live, 8);
+
+    ThrowingCopy::copies_left = 4; // while growing, the ring is unchanged
+    EXPECT_THROW(ring.emplace_front(8), std::runtime_error);
+    EXPECT_EQ(ThrowingCopy::live, 8);
+    EXPECT_EQ(ring.size(), 8u);
+    EXPECT_EQ(ring.capacity(), 8u);
+    EXPECT_EQ(ring.front().value, 7);
+    EXPECT_EQ(ring.back().value, 0);
+
+    ThrowingCopy::copies_left = -1;
+    const RingBuffer<ThrowingCopy> copy{ring};
+    EXPECT_EQ(copy.size(), 8u);
+    EXPECT_EQ(ThrowingCopy::live, 16);
+  }
+  EXPECT_EQ(ThrowingCopy::live, 0);
+}
+
+TEST(RingBufferInt, LinearizeKeepsOrder) {
+  RingBuffer<int> ring;
+  ring.reserve(8);
+  for (int i = 0; i < 8; ++i) {
+    ring.push_front(i);
+  }
+  ring.erase(ring.begin() + 1, ring.begin() + 3); // frees the last 2 slots
+  ring.push_front(8);
+  ring.push_front(9); // full again, and wrapped
+  ASSERT_EQ(ring.capacity(), 8u);
+  ASSERT_TRUE(is_wrapped(ring));
+  const std::deque<int> expected(ring.begin(), ring.end());
+  const auto cards = ring.linearize();
+  EXPECT_FALSE(is_wrapped(ring));
+  EXPECT_EQ(cards.data(), &ring.front());
+  EXPECT_TRUE(std::equal(cards.begin(), cards.end(), expected.begin(),
+                         expected.end()));
+}
+
+TEST(ShuffleEngine, BoundedRandomStaysInRange) {
+  Pcg32 gen{5544, 0};
+  std::array<int, 6> counts{};
+  for (int i = 0; i < 60'000; ++i) {
+    const auto n = bounded_random(gen, counts.size());
+    ASSERT_LT(n, counts.size());
+    ++counts[n];
+  }
+  for (const auto count : counts) { // roughly 10'000 each
+    EXPECT_NEAR(count, 10'000, 500);
+  }
+}
+
+TEST(ShuffleEngine, ShuffleKeepsCards) {
+  ShuffleEngine engine{5544, 2};
+  std::vector<RingDeck<int>> decks(100);
+  for (auto &deck : decks) {
+    for (int i = 52; i > 0; i--) {
+      deck.add(i);
+    }
+  }
+  const auto sorted{decks.front()};
+
+  engine.shuffle(std::span{decks});
+  for (auto &deck : decks) {
+    EXPECT_NE(sorted, deck);
+    std::sort(deck.begin(), deck.end());
+    EXPECT_EQ(sorted, deck);
+  }
+}
+
+TEST(ShuffleEngine, ReproducibleForAnyThreadCount) {
+  std::vector<Deck<int>> prototype(1'000);
+  for (auto &deck : prototype) {
+    for (int i = 52; i > 0; i--) {
+      deck.add(i);
+    }
+  }
+
+  // two batches, so the streams must continue across calls
+  std::vector<std::vector<Deck<int>>> results;
+  for (unsigned threads : {1u, 3u, 8u}) {
+    ShuffleEngine engine{42, threads};
+    EXPECT_EQ(threads, engine.threads());
+    auto decks{prototype};
+    engine.shuffle(std::span{decks}.first(300));
+    engine.shuffle(std::span{decks}.subspan(300));
+    results.push_back(std::move(decks));
+  }
+  EXPECT_EQ(results[0], results[1]);
+  EXPECT_EQ(results[0], results[2]);
+  EXPECT_NE(results[0][0], results[0][1]);
+}
+
+TEST(CardSet, MembershipAndCounting) {
+  const Card ace{Rank::Ace, Suit::Spades};
+  const Card two{Rank::Two, Suit::Clubs};
+  CardSet set;
+
+  EXPECT_TRUE(set.empty());
+  set.insert(ace);
+  set.insert(two);
+  set.insert(ace);
+  EXPECT_EQ(2, set.size());
+  EXPECT_TRUE(set.contains(ace));
+  set.remove(ace);
+  EXPECT_FALSE(set.contains(ace));
+  EXPECT_EQ((std::vector<Card>{two}), std::vector<Card>(set.begin(), set.end()));
+  EXPECT_EQ(sizeof(Card), 1);
+}
+
+TEST(CardSet, SetAlgebra) {
+  const auto full = CardSet::full();
+  EXPECT_EQ(52, full.size());
+
+  const auto spades = CardSet::of_suit(Suit::Spades);
+  EXPECT_EQ(13, spades.size());
+  EXPECT_EQ(spades, full & spades);
+  EXPECT_EQ(39, (full - spades).size());
+  EXPECT_EQ(0x1fff, full.ranks(Suit::Hearts));
+  EXPECT_EQ(0, (full - spades).ranks(Suit::Spades));
+
+  CardSet hand;
+  hand.insert({Rank::Ace, Suit::Hearts});
+  hand.insert({Rank::King, Suit::Hearts});
+  EXPECT_EQ(11, ((full - hand) & CardSet::of_suit(Suit::Hearts)).size());
+}
+
+TEST(PackedDeck, FullDeckOrder) {
+  auto deck = PackedDeck::full();
+  EXPECT_EQ(52, deck.size());
+  EXPECT_EQ(Card(Rank::Two, Suit::Clubs), deck.top().value());
+  EXPECT_EQ(Card(Rank::Ace, Suit::Spades), deck.bottom().value());
+  EXPECT_EQ(CardSet::full(), deck.cards());
+
+  int n = 0;
+  for (auto it = deck.cbegin(); it != deck.cend(); ++it, ++n) {
+    EXPECT_EQ(Card(static_cast<Rank>(n % 13), static_cast<Suit>(n / 13)), *it);
+  }
+}
+
+TEST(PackedDeck, DrawAddRemove) {
+  auto deck = PackedDeck::full();
+  const Card queen{Rank::Queen, Suit::Diamonds};
+
+  EXPECT_TRUE(deck.remove(queen));
+  EXPECT_FALSE(deck.remove(queen));
+  EXPECT_FALSE(deck.contains(queen));
+  EXPECT_EQ(51, deck.size());
+  EXPECT_EQ(51, deck.cards().size());
+  EXPECT_EQ(deck.cend(), std::find(deck.cbegin(), deck.cend(), queen));
+
+  const auto top = deck.draw();
+  EXPECT_FALSE(deck.contains(top.value()));
+  EXPECT_FALSE(deck.add(Card{Rank::Ace, Suit::Spades})); // still in the deck
+  EXPECT_TRUE(deck.add(queen));
+  EXPECT_EQ(queen, deck.top().value());
+  EXPECT_EQ(51, deck.size());
+}
+
+TEST(PackedDeck, ShuffleKeepsCards) {
+  auto deck = PackedDeck::full();
+  const auto sorted{deck};
+
+  deck.shuffle(std::mt19937{5544});
+  EXPECT_NE(sorted, deck);
+  EXPECT_EQ(sorted.cards(), deck.cards());
+  while (const auto card = deck.draw()) {
+    EXPECT_TRUE(sorted.contains(*card));
+  }
+}
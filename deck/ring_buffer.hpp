@@ -0,0 +1,310 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <compare>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+/*! \brief Double-ended sequence stored in one contiguous power-of-two buffer.
+ *
+ *  Elements occupy the slots [head, head + size) modulo the capacity, so
+ *  push_front/pop_front are O(1) and random access is a mask, not a chunk
+ *  lookup as in std::deque. The buffer grows by doubling.
+ */
+template <typename T> class RingBuffer {
+  template <bool Const> class Iterator;
+
+public:
+  typedef T value_type;
+  typedef std::size_t size_type;
+  typedef std::ptrdiff_t difference_type;
+  typedef T &reference;
+  typedef const T &const_reference;
+  typedef Iterator<false> iterator;
+  typedef Iterator<true> const_iterator;
+
+public:
+  /*! \brief Creates an empty buffer, nothing is allocated */
+  RingBuffer() noexcept = default;
+  /*! \brief Creates a copy of `rhs` */
+  RingBuffer(const RingBuffer &rhs) {
+    if (!rhs.empty()) {
+      const size_type capacity = std::bit_ceil(std::max(rhs.size(), kMinCapacity));
+      Block block{capacity, capacity - rhs.size()};
+      for (const T &value : rhs) {
+        block.emplace_back(value);
+      }
+      adopt(block);
+    }
+  }
+  /*! \brief Takes the buffer of `rhs`, leaving it empty */
+  RingBuffer(RingBuffer &&rhs) noexcept { swap(rhs); }
+
+  /*! \brief Copy elements from `rhs` */
+  RingBuffer &operator=(const RingBuffer &rhs) {
+    if (this != &rhs) {
+      RingBuffer copy{rhs};
+      swap(copy);
+    }
+    return *this;
+  }
+  /*! \brief Takes the buffer of `rhs`, leaving it empty */
+  RingBuffer &operator=(RingBuffer &&rhs) noexcept {
+    RingBuffer moved{std::move(rhs)};
+    swap(moved);
+    return *this;
+  }
+
+  /*! \brief Destroys the elements and releases the buffer */
+  ~RingBuffer() {
+    clear();
+    std::allocator<T>{}.deallocate(m_data, m_capacity);
+  }
+
+  iterator begin() noexcept { return {this, 0}; }
+  iterator end() noexcept { return {this, m_size}; }
+  const_iterator begin() const noexcept { return {this, 0}; }
+  const_iterator end() const noexcept { return {this, m_size}; }
+  const_iterator cbegin() const noexcept { return begin(); }
+  const_iterator cend() const noexcept { return end(); }
+
+  T &front() { return m_data[m_head]; }
+  const T &front() const { return m_data[m_head]; }
+  T &back() { return m_data[slot(m_size - 1)]; }
+  const T &back() const { return m_data[slot(m_size - 1)]; }
+
+  /*! \brief Constructs an element in front of the first one */
+  template <typename... Args> T &emplace_front(Args &&...args) {
+    if (m_size == m_capacity) {
+      // args may refer to an element: construct the new one before the old
+      // buffer is released
+      relocate<true>(m_capacity ? 2 * m_capacity : kMinCapacity,
+                     std::forward<Args>(args)...);
+    } else {
+      const size_type head = (m_head - 1) & (m_capacity - 1);
+      std::construct_at(m_data + head, std::forward<Args>(args)...);
+      m_head = head;
+      ++m_size;
+    }
+    return m_data[m_head];
+  }
+  void push_front(const T &value) { emplace_front(value); }
+  void push_front(T &&value) { emplace_front(std::move(value)); }
+
+  /*! \brief Destroys the first element */
+  void pop_front() {
+    std::destroy_at(m_data + m_head);
+    m_head = (m_head + 1) & (m_capacity - 1);
+    --m_size;
+  }
+
+  /*! \brief Destroys the elements in [first, last). Erasing from the front
+   *  only moves the head, otherwise the following elements move up.
+   */
+  iterator erase(const_iterator first, const_iterator last) {
+    const size_type pos = first.m_pos;
+    const size_type count = last.m_pos - first.m_pos;
+    if (pos == 0) {
+      for (size_type i = 0; i < count; ++i) {
+        std::destroy_at(m_data + slot(i));
+      }
+      m_head = slot(count);
+    } else {
+      std::move(begin() + pos + count, end(), begin() + pos);
+      for (size_type i = m_size - count; i < m_size; ++i) {
+        std::destroy_at(m_data + slot(i));
+      }
+    }
+    m_size -= count;
+    return begin() + pos;
+  }
+
+  void clear() noexcept {
+    for (size_type i = 0; i < m_size; ++i) {
+      std::destroy_at(m_data + slot(i));
+    }
+    m_size = 0;
+  }
+
+  void swap(RingBuffer &rhs) noexcept {
+    std::swap(m_data, rhs.m_data);
+    std::swap(m_capacity, rhs.m_capacity);
+    std::swap(m_head, rhs.m_head);
+    std::swap(m_size, rhs.m_size);
+  }
+
+  size_type size() const noexcept { return m_size; }
+  size_type max_size() const noexcept {
+    return std::allocator_traits<std::allocator<T>>::max_size(
+        std::allocator<T>{});
+  }
+  size_type capacity() const noexcept { return m_capacity; }
+  bool empty() const noexcept { return m_size == 0; }
+
+  /*! \brief Makes room for at least `n` elements, rounded up to a power of 2 */
+  void reserve(size_type n) {
+    if (n > m_capacity) {
+      relocate(std::bit_ceil(std::max(n, kMinCapacity)));
+    }
+  }
+
+  /*! \brief Moves the elements into one unwrapped block and returns it.
+   *  The elements keep their order, iterators are invalidated.
+   */
+  std::span<T> linearize() {
+    if (m_head + m_size > m_capacity) {
+      relocate(m_capacity);
+    }
+    return {m_data + m_head, m_size};
+  }
+
+private:
+  static constexpr size_type kMinCapacity = 8;
+
+  size_type slot(size_type i) const noexcept {
+    return (m_head + i) & (m_capacity - 1);
+  }
+
+  /*! \brief A new buffer being filled with the elements [first, first + n).
+   *  Unless adopt() takes it over, the elements built so far are destroyed
+   *  and the buffer is released, so a throwing constructor leaks nothing.
+   */
+  class Block {
+  public:
+    Block(size_type capacity, size_type first)
+        : m_data(std::allocator<T>{}.allocate(capacity)), m_capacity(capacity),
+          m_first(first) {}
+    Block(const Block &) = delete;
+    Block &operator=(const Block &) = delete;
+    ~Block() {
+      if (m_data) {
+        std::destroy(m_data + m_first, m_data + m_first + m_size);
+        std::allocator<T>{}.deallocate(m_data, m_capacity);
+      }
+    }
+
+    /*! \brief Constructs the element after the ones built so far */
+    template <typename... Args> void emplace_back(Args &&...args) {
+      std::construct_at(m_data + m_first + m_size, std::forward<Args>(args)...);
+      ++m_size;
+    }
+
+  private:
+    friend class RingBuffer;
+
+    T *m_data;
+    size_type m_capacity;
+    size_type m_first;
+    size_type m_size = 0;
+  };
+
+  /*! \brief Replaces the elements and buffer by those of `block` */
+  void adopt(Block &block) noexcept {
+    clear();
+    std::allocator<T>{}.deallocate(m_data, m_capacity);
+    m_data = std::exchange(block.m_data, nullptr);
+    m_capacity = block.m_capacity;
+    m_head = block.m_first & (m_capacity - 1);
+    m_size = block.m_size;
+  }
+
+  /*! \brief Moves the elements to a new buffer of `capacity` slots. They are
+   *  placed at its end, leaving the free slots in front for push_front.
+   *  With `Emplace`, an element constructed from `args` is put in front of
+   *  them. If a constructor throws, the ring is left unchanged.
+   */
+  template <bool Emplace = false, typename... Args>
+  void relocate(size_type capacity, Args &&...args) {
+    Block block{capacity, capacity - m_size - (Emplace ? 1 : 0)};
+    if constexpr (Emplace) {
+      block.emplace_back(std::forward<Args>(args)...);
+    }
+    for (size_type i = 0; i < m_size; ++i) {
+      block.emplace_back(std::move_if_noexcept(m_data[slot(i)]));
+    }
+    adopt(block);
+  }
+
+  T *m_data = nullptr;
+  size_type m_capacity = 0;
+  size_type m_head = 0;
+  size_type m_size = 0;
+};
+
+/*! \brief Random access iterator over the logical positions of a RingBuffer */
+template <typename T>
+template <bool Const>
+class RingBuffer<T>::Iterator {
+  friend class RingBuffer;
+  template <bool> friend class Iterator;
+  typedef std::conditional_t<Const, const RingBuffer, RingBuffer> ring_t;
+
+public:
+  typedef std::random_access_iterator_tag iterator_category;
+  typedef std::random_access_iterator_tag iterator_concept;
+  typedef T value_type;
+  typedef std::ptrdiff_t difference_type;
+  typedef std::conditional_t<Const, const T, T> *pointer;
+  typedef std::conditional_t<Const, const T, T> &reference;
+
+  Iterator() noexcept = default;
+  Iterator(const Iterator &) noexcept = default;
+  Iterator &operator=(const Iterator &) noexcept = default;
+  /*! \brief iterator converts to const_iterator */
+  Iterator(const Iterator<false> &it) noexcept
+    requires Const
+      : m_ring(it.m_ring), m_pos(it.m_pos) {}
+
+  reference operator*() const { return m_ring->m_data[m_ring->slot(m_pos)]; }
+  pointer operator->() const { return &**this; }
+  reference operator[](difference_type n) const { return *(*this + n); }
+
+  Iterator &operator++() noexcept {
+    ++m_pos;
+    return *this;
+  }
+  Iterator operator++(int) noexcept { return {m_ring, m_pos++}; }
+  Iterator &operator--() noexcept {
+    --m_pos;
+    return *this;
+  }
+  Iterator operator--(int) noexcept { return {m_ring, m_pos--}; }
+  Iterator &operator+=(difference_type n) noexcept {
+    m_pos += n;
+    return *this;
+  }
+  Iterator &operator-=(difference_type n) noexcept {
+    m_pos -= n;
+    return *this;
+  }
+  Iterator operator+(difference_type n) const noexcept {
+    return {m_ring, m_pos + n};
+  }
+  friend Iterator operator+(difference_type n, const Iterator &it) noexcept {
+    return it + n;
+  }
+  Iterator operator-(difference_type n) const noexcept {
+    return {m_ring, m_pos - n};
+  }
+  difference_type operator-(const Iterator &rhs) const noexcept {
+    return static_cast<difference_type>(m_pos) -
+           static_cast<difference_type>(rhs.m_pos);
+  }
+
+  bool operator==(const Iterator &rhs) const noexcept {
+    return m_pos == rhs.m_pos;
+  }
+  std::strong_ordering operator<=>(const Iterator &rhs) const noexcept {
+    return m_pos <=> rhs.m_pos;
+  }
+
+private:
+  Iterator(ring_t *ring, size_type pos) noexcept : m_ring(ring), m_pos(pos) {}
+
+  ring_t *m_ring = nullptr;
+  size_type m_pos = 0;
+};
@@ -0,0 +1,192 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/*! \brief PCG32 (XSH-RR) random bit generator. Every `stream` is its own
+ *  sequence, so each deck of a batch can get an independent generator.
+ */
+class Pcg32 {
+public:
+  typedef std::uint32_t result_type;
+
+  Pcg32(std::uint64_t seed, std::uint64_t stream) noexcept
+      : m_state(0), m_inc((stream << 1u) | 1u) {
+    (*this)();
+    m_state += splitmix64(seed ^ splitmix64(stream));
+    (*this)();
+  }
+
+  static constexpr result_type min() noexcept { return 0; }
+  static constexpr result_type max() noexcept { return UINT32_MAX; }
+
+  result_type operator()() noexcept {
+    const std::uint64_t old = m_state;
+    m_state = old * 6364136223846793005ULL + m_inc;
+    const auto xorshifted =
+        static_cast<std::uint32_t>(((old >> 18u) ^ old) >> 27u);
+    const auto rot = static_cast<std::uint32_t>(old >> 59u);
+    return (xorshifted >> rot) | (xorshifted << ((-rot) & 31u));
+  }
+
+private:
+  /*! \brief spreads nearby seeds and streams over the whole state */
+  static std::uint64_t splitmix64(std::uint64_t x) noexcept {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30u)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27u)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31u);
+  }
+
+  std::uint64_t m_state;
+  std::uint64_t m_inc;
+};
+
+/*! \brief Uniform number in [0, range) from a 32 bit generator.
+ *  Multiplies instead of taking a modulo (Lemire); the single division only
+ *  happens for the rare samples that may be biased.
+ */
+template <typename Gen>
+std::uint32_t bounded_random(Gen &gen, std::uint32_t range) {
+  std::uint64_t m = std::uint64_t{gen()} * range;
+  auto low = static_cast<std::uint32_t>(m);
+  if (low < range) {
+    const std::uint32_t threshold = -range % range;
+    while (low < threshold) {
+      m = std::uint64_t{gen()} * range;
+      low = static_cast<std::uint32_t>(m);
+    }
+  }
+  return static_cast<std::uint32_t>(m >> 32u);
+}
+
+/*! \brief Fisher-Yates shuffle of [first, last) using bounded_random */
+template <std::random_access_iterator It, typename Gen>
+void fisher_yates_shuffle(It first, It last, Gen &gen) {
+  using std::swap;
+  for (auto i = static_cast<std::uint32_t>(last - first); i > 1; --i) {
+    swap(first[i - 1], first[bounded_random(gen, i)]);
+  }
+}
+
+/*! \brief Shuffles batches of decks on a pool of threads.
+ *
+ *  The n-th deck shuffled since construction always uses Pcg32{seed, n}, so
+ *  the results only depend on the seed and the order of the decks, never on
+ *  the number of threads.
+ */
+class ShuffleEngine {
+public:
+  /*! \param seed master seed of all shuffles
+   *  \param threads total number of threads, including the calling one
+   */
+  explicit ShuffleEngine(std::uint64_t seed,
+                         unsigned threads = std::thread::hardware_concurrency())
+      : m_seed(seed) {
+    for (unsigned i = 1; i < threads; ++i) {
+      m_workers.emplace_back([this] { workerLoop(); });
+    }
+  }
+
+  ShuffleEngine(const ShuffleEngine &) = delete;
+  ShuffleEngine &operator=(const ShuffleEngine &) = delete;
+
+  /*! \brief Stops and joins the worker threads */
+  ~ShuffleEngine() {
+    {
+      std::lock_guard lock{m_mutex};
+      m_stop = true;
+    }
+    m_wake.notify_all();
+  }
+
+  unsigned threads() const noexcept {
+    return static_cast<unsigned>(m_workers.size()) + 1;
+  }
+
+  /*! \brief Shuffles every deck, blocks until all are done */
+  template <typename Deck> void shuffle(std::span<Deck> decks) {
+    const std::uint64_t first_stream = m_next_stream;
+    m_next_stream += decks.size();
+    run(decks.size(), [&](std::size_t begin, std::size_t end) {
+      for (auto i = begin; i < end; ++i) {
+        Pcg32 gen{m_seed, first_stream + i};
+        fisher_yates_shuffle(decks[i].begin(), decks[i].end(), gen);
+      }
+    });
+  }
+
+private:
+  /*! \brief decks claimed by a thread at once */
+  static constexpr std::size_t kChunk = 64;
+
+  /*! \brief Runs job over [0, size) in chunks, on all threads */
+  void run(std::size_t size, std::function<void(std::size_t, std::size_t)> job) {
+    {
+      std::lock_guard lock{m_mutex};
+      m_job = std::move(job);
+      m_job_size = size;
+      m_next.store(0, std::memory_order_relaxed);
+      m_busy = static_cast<unsigned>(m_workers.size());
+      ++m_generation;
+    }
+    m_wake.notify_all();
+    work();
+
+    std::unique_lock lock{m_mutex};
+    m_done.wait(lock, [this] { return m_busy == 0; });
+    m_job = nullptr;
+  }
+
+  void work() {
+    std::size_t begin;
+    while ((begin = m_next.fetch_add(kChunk, std::memory_order_relaxed)) <
+           m_job_size) {
+      m_job(begin, std::min(begin + kChunk, m_job_size));
+    }
+  }
+
+  void workerLoop() {
+    std::uint64_t generation = 0;
+    while (true) {
+      {
+        std::unique_lock lock{m_mutex};
+        m_wake.wait(lock,
+                    [&] { return m_stop || m_generation != generation; });
+        if (m_stop) {
+          return;
+        }
+        generation = m_generation;
+      }
+      work();
+      std::lock_guard lock{m_mutex};
+      if (--m_busy == 0) {
+        m_done.notify_one();
+      }
+    }
+  }
+
+  const std::uint64_t m_seed;
+  std::uint64_t m_next_stream = 0;
+
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::condition_variable m_done;
+  std::function<void(std::size_t, std::size_t)> m_job;
+  std::size_t m_job_size = 0;
+  std::atomic<std::size_t> m_next{0};
+  unsigned m_busy = 0;
+  std::uint64_t m_generation = 0;
+  bool m_stop = false;
+  // last member: the threads are joined before the state above is destroyed
+  std::vector<std::jthread> m_workers;
+};
@@ -1,17 +1,58 @@
+#include <functional>
 #include <iostream>
+#include <iterator>
 #include <map>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+#include <type_traits>
 
 class IntervalMapTest;
 
-template <typename K, typename V> class interval_map {
+template <typename K, typename V,
+          typename Allocator = std::allocator<std::pair<const K, V>>>
+class interval_map;
+
+// value type produced by merging an interval_map<K, VA> with an
+// interval_map<K, VB> through combine(VA, VB)
+template <typename Combine, typename VA, typename VB>
+using interval_map_merge_t = std::decay_t<
+    std::invoke_result_t<Combine &, VA const &, VB const &>>;
+
+// Allocator rebound to the node value type of an interval_map<K, V>
+template <typename Allocator, typename K, typename V>
+using interval_map_rebind_t = typename std::allocator_traits<
+    Allocator>::template rebind_alloc<std::pair<const K, V>>;
+
+template <typename K, typename VA, typename VB, typename AA, typename AB,
+          typename Combine>
+interval_map<K, interval_map_merge_t<Combine, VA, VB>,
+             interval_map_rebind_t<AA, K, interval_map_merge_t<Combine, VA, VB>>>
+merge(interval_map<K, VA, AA> const &a, interval_map<K, VB, AB> const &b,
+      Combine combine);
+
+// Allocator is used for the nodes of the underlying std::map, so a pool can
+// serve the breakpoints. \see pmr::interval_map
+template <typename K, typename V, typename Allocator> class interval_map {
   friend class IntervalMapTest;
+  friend class IntervalMapFuzzTest;
   friend void IntervalMapTest();
+  template <typename K2, typename VA, typename VB, typename AA, typename AB,
+            typename Combine>
+  friend interval_map<
+      K2, interval_map_merge_t<Combine, VA, VB>,
+      interval_map_rebind_t<AA, K2, interval_map_merge_t<Combine, VA, VB>>>
+  merge(interval_map<K2, VA, AA> const &a, interval_map<K2, VB, AB> const &b,
+        Combine combine);
   V m_valBegin;
-  std::map<K, V> m_map;
+  std::map<K, V, std::less<K>, Allocator> m_map;
 
 public:
   // constructor associates whole range of K with val
-  interval_map(V const &val) : m_valBegin(val) {}
+  interval_map(V const &val, Allocator const &alloc = Allocator())
+      : m_valBegin(val), m_map(alloc) {}
+  interval_map(V &&val, Allocator const &alloc = Allocator())
+      : m_valBegin(std::move(val)), m_map(alloc) {}
 
   // Assign value val to interval [keyBegin, keyEnd).
   // Overwrite previous values in this interval.
@@ -19,35 +60,33 @@ public:
   // includes keyBegin, but excludes keyEnd.
   // If !( keyBegin < keyEnd ), this designates an empty interval,
   // and assign must do nothing.
+  // Breakpoints that are overwritten are reused for the new ones, so
+  // reassigning existing ranges does not allocate.
   void assign(K const &keyBegin, K const &keyEnd, V const &val) {
-    // ===== is this going to be the first entry?
-    const auto it_lower_bound = m_map.lower_bound(keyBegin);
-    if ((val == m_valBegin) && 
-        !(m_map.cbegin()->first < it_lower_bound->first)) {
-      // first entry cannot be the same as m_valBegin
-      return;
+    if (keyBegin < keyEnd) {
+      // val may refer to a value stored in this map, which assign_impl can
+      // erase; the node copies the value anyway, so copy it first
+      V copy(val);
+      assign_impl(keyBegin, keyEnd, std::move(copy));
     }
+  }
+  void assign(K const &keyBegin, K const &keyEnd, V &&val) {
+    assign_impl(keyBegin, keyEnd, std::move(val));
+  }
 
-    // ===== Get a hint on where the iterator should be. (optmized insert)
-    bool skip_prev_value_check{false};
-    typename std::map<K, V>::const_iterator it_prev{it_lower_bound};
-
-    if (m_map.size() < 2) {
-      it_prev = m_map.cbegin();
-      skip_prev_value_check = true;
-    } else {
-      // hint needs to point 1 element before where we want to insert.
-      --it_prev;
+  // Like assign, with the value constructed from args. The value is moved
+  // into the map, never copied.
+  template <typename... Args>
+  void emplace(K const &keyBegin, K const &keyEnd, Args &&...args) {
+    if (keyBegin < keyEnd) {
+      assign_impl(keyBegin, keyEnd, V(std::forward<Args>(args)...));
     }
+  }
 
-    // ==== check next and prev. key - the values range must be canonical
-    if ((!skip_prev_value_check && (it_prev->second == val)) ||
-        (m_map.upper_bound(keyEnd)->second == val)) {
-      return;
-    }
+  // number of breakpoints, i.e. the number of stored intervals
+  std::size_t size() const noexcept { return m_map.size(); }
 
-    m_map.insert_or_assign(keyBegin, val);
-  }
+  Allocator get_allocator() const { return m_map.get_allocator(); }
 
   // look-up of the value associated with key
   V const &operator[](K const &key) const {
@@ -58,9 +97,129 @@ public:
       return (--it)->second;
     }
   }
+
+private:
+  template <typename Val>
+  void assign_impl(K const &keyBegin, K const &keyEnd, Val &&val) {
+    if (!(keyBegin < keyEnd)) {
+      return;
+    }
+
+    // ===== keyEnd: restore the value that was in effect there before
+    auto it_end = m_map.lower_bound(keyEnd);
+    if (it_end != m_map.end() && !(keyEnd < it_end->first)) {
+      // keyEnd is already a breakpoint, drop it if it no longer changes value
+      if (it_end->second == val) {
+        it_end = m_map.erase(it_end);
+      }
+    } else {
+      auto it_last = (it_end == m_map.begin()) ? m_map.end() : std::prev(it_end);
+      V const &val_end = (it_last == m_map.end()) ? m_valBegin : it_last->second;
+      if (!(val_end == val)) {
+        if (it_last != m_map.end() && !(it_last->first < keyBegin)) {
+          // the breakpoint in effect is inside [keyBegin, keyEnd) and would be
+          // erased below: move its node to keyEnd instead of copying the value
+          auto node = m_map.extract(it_last);
+          node.key() = keyEnd;
+          it_end = m_map.insert(it_end, std::move(node));
+        } else {
+          it_end = m_map.emplace_hint(it_end, keyEnd, val_end);
+        }
+      }
+    }
+
+    // ===== keyBegin: only a breakpoint if the value before it differs
+    auto it_begin = m_map.lower_bound(keyBegin);
+    V const &val_before =
+        (it_begin == m_map.begin()) ? m_valBegin : std::prev(it_begin)->second;
+    if (val_before == val) {
+      m_map.erase(it_begin, it_end);
+    } else if (it_begin == it_end) {
+      m_map.emplace_hint(it_end, keyBegin, std::forward<Val>(val));
+    } else if (!(keyBegin < it_begin->first)) {
+      // reuse the existing node at keyBegin
+      it_begin->second = std::forward<Val>(val);
+      m_map.erase(std::next(it_begin), it_end);
+    } else {
+      // reuse the first overwritten node, moved to keyBegin
+      auto node = m_map.extract(it_begin++);
+      node.key() = keyBegin;
+      node.mapped() = std::forward<Val>(val);
+      m_map.erase(it_begin, it_end);
+      m_map.insert(it_end, std::move(node));
+    }
+  }
 };
 
+namespace pmr {
+// interval_map whose breakpoints are allocated from a memory_resource, e.g.
+// a std::pmr::unsynchronized_pool_resource
+template <typename K, typename V>
+using interval_map =
+    ::interval_map<K, V, std::pmr::polymorphic_allocator<std::pair<const K, V>>>;
+} // namespace pmr
+
+// Merge two maps segment by segment: every key k of the result is associated
+// with combine(a[k], b[k]).
+// Both canonical breakpoint sequences are swept at once, so this runs in
+// O(n + m) instead of the O(n log n) of repeated assign calls. The result is
+// canonical as well: a breakpoint is only emitted when the combined value
+// changes.
+// Overlaying a patch on top of a base layer is a merge where the patch
+// value type can express "no override", e.g.
+//   merge(base, patch, [](V const &v, std::optional<V> const &p) {
+//     return p ? *p : v;
+//   });
+// The result allocates from the allocator of a.
+template <typename K, typename VA, typename VB, typename AA, typename AB,
+          typename Combine>
+interval_map<K, interval_map_merge_t<Combine, VA, VB>,
+             interval_map_rebind_t<AA, K, interval_map_merge_t<Combine, VA, VB>>>
+merge(interval_map<K, VA, AA> const &a, interval_map<K, VB, AB> const &b,
+      Combine combine) {
+  using V = interval_map_merge_t<Combine, VA, VB>;
+  interval_map<K, V, interval_map_rebind_t<AA, K, V>> result(
+      std::invoke(combine, a.m_valBegin, b.m_valBegin),
+      interval_map_rebind_t<AA, K, V>(a.m_map.get_allocator()));
+
+  // values currently in effect on each side of the sweep
+  VA const *val_a = &a.m_valBegin;
+  VB const *val_b = &b.m_valBegin;
+  V const *val_last = &result.m_valBegin;
+
+  auto it_a = a.m_map.cbegin();
+  auto it_b = b.m_map.cbegin();
+  while (it_a != a.m_map.cend() || it_b != b.m_map.cend()) {
+    // ===== pick the next breakpoint; K only provides operator<
+    K const *key;
+    if (it_b == b.m_map.cend() ||
+        (it_a != a.m_map.cend() && it_a->first < it_b->first)) {
+      key = &it_a->first;
+      val_a = &(it_a++)->second;
+    } else if (it_a == a.m_map.cend() || it_b->first < it_a->first) {
+      key = &it_b->first;
+      val_b = &(it_b++)->second;
+    } else { // both maps break at the same key
+      key = &it_a->first;
+      val_a = &(it_a++)->second;
+      val_b = &(it_b++)->second;
+    }
+
+    // ===== only emit a breakpoint if the value changes (canonical form)
+    V val = std::invoke(combine, *val_a, *val_b);
+    if (!(val == *val_last)) {
+      // keys arrive in ascending order: hinted insert at end is O(1)
+      val_last = &result.m_map.emplace_hint(result.m_map.cend(), *key,
+                                            std::move(val))
+                      ->second;
+    }
+  }
+  return result;
+}
+
 // Many solutions we receive are incorrect. Consider using a randomized test
 // to discover the cases that your implementation does not handle correctly.
 // We recommend to implement a test function that tests the functionality of
 // the interval_map, for example using a map of int intervals to char.
+// -> interval_map_fuzz_test.cpp compares every operation against a naive
+//    array model.
@@ -0,0 +1,132 @@
+#include "interval_map.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <vector>
+
+// Throughput benchmark for interval_map: assign and look-up rate, and the
+// heap memory used per stored interval, for a range of map sizes and key
+// distributions. Built with optimisations, see CMakeLists.txt.
+
+// ===== count live heap bytes, so memory per interval can be reported.
+// std::allocator releases memory through the sized operator delete.
+static std::size_t g_live_bytes = 0;
+
+void *operator new(std::size_t size) {
+  g_live_bytes += size;
+  if (void *p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc{};
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+
+void operator delete(void *ptr, std::size_t size) noexcept {
+  g_live_bytes -= size;
+  std::free(ptr);
+}
+
+enum class Distribution { Uniform, Sequential, Clustered };
+
+static const char *name(Distribution d) {
+  switch (d) {
+  case Distribution::Uniform:
+    return "uniform";
+  case Distribution::Sequential:
+    return "sequential";
+  case Distribution::Clustered:
+    return "clustered";
+  }
+  return "";
+}
+
+struct Interval {
+  int keyBegin;
+  int keyEnd;
+  int val;
+};
+
+// short intervals in a key space 8 times their count, so most of them stay
+// disjoint and the map grows with `size`
+static std::vector<Interval> makeIntervals(Distribution d, int size,
+                                           std::mt19937 &gen) {
+  const int key_space = size * 8;
+  std::uniform_int_distribution<int> length(1, 8);
+  std::uniform_int_distribution<int> uniform(0, key_space);
+  std::normal_distribution<double> clustered(key_space / 2.0, key_space / 16.0);
+  std::uniform_int_distribution<int> value(0, 15);
+
+  std::vector<Interval> intervals;
+  intervals.reserve(size);
+  for (int i = 0; i < size; ++i) {
+    int key = 0;
+    switch (d) {
+    case Distribution::Uniform:
+      key = uniform(gen);
+      break;
+    case Distribution::Sequential:
+      key = i * 8;
+      break;
+    case Distribution::Clustered:
+      key = static_cast<int>(clustered(gen));
+      break;
+    }
+    intervals.push_back({key, key + length(gen), value(gen)});
+  }
+  return intervals;
+}
+
+template <typename F> static double secondsFor(F &&f) {
+  const auto start = std::chrono::steady_clock::now();
+  f();
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+int main() {
+  std::printf("%-11s %9s %10s %14s %14s %14s\n", "keys", "size", "intervals",
+              "assign/s", "lookup/s", "bytes/interval");
+
+  for (auto d : {Distribution::Uniform, Distribution::Sequential,
+                 Distribution::Clustered}) {
+    for (int size : {1'000, 10'000, 100'000, 1'000'000}) {
+      std::mt19937 gen{5544};
+      const auto intervals = makeIntervals(d, size, gen);
+      std::vector<int> lookups(intervals.size());
+      std::uniform_int_distribution<int> key(0, size * 8);
+      for (auto &k : lookups) {
+        k = key(gen);
+      }
+
+      const std::size_t bytes_before = g_live_bytes;
+      interval_map<int, int> m{-1};
+      const double assign_s = secondsFor([&] {
+        for (auto const &i : intervals) {
+          m.assign(i.keyBegin, i.keyEnd, i.val);
+        }
+      });
+      const std::size_t bytes = g_live_bytes - bytes_before;
+
+      long long checksum = 0;
+      const double lookup_s = secondsFor([&] {
+        for (int k : lookups) {
+          checksum += m[k];
+        }
+      });
+
+      std::printf("%-11s %9d %10zu %14.0f %14.0f %14.1f\n", name(d), size,
+                  m.size(), intervals.size() / assign_s,
+                  lookups.size() / lookup_s,
+                  m.size() ? static_cast<double>(bytes) / m.size() : 0.0);
+      // keep the look-ups from being optimised away
+      if (checksum == 42) {
+        std::puts("");
+      }
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,144 @@
+#include "interval_map.hpp"
+#include <array>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+
+// Differential test: every operation on interval_map is mirrored on a naive
+// array model covering the keys [kKeyMin, kKeyMax). assign only touches
+// [0, kKeys), so the keys around it check the values before and after.
+class IntervalMapFuzzTest : public ::testing::TestWithParam<unsigned> {
+protected:
+  static constexpr int kKeys = 32;
+  static constexpr int kKeyMin = -4;
+  static constexpr int kKeyMax = kKeys + 4;
+  static constexpr int kIterations = 2'000;
+
+  using interval_map_t = interval_map<int, char>;
+  using model_t = std::array<char, kKeyMax - kKeyMin>;
+
+  void SetUp() override { gen_.seed(GetParam()); }
+
+  // a small alphabet makes neighbouring intervals share values often
+  char randomValue() {
+    return static_cast<char>(std::uniform_int_distribution<int>('A', 'D')(gen_));
+  }
+  int randomKey() { return std::uniform_int_distribution<int>(0, kKeys)(gen_); }
+
+  static model_t makeModel(char val) {
+    model_t model;
+    model.fill(val);
+    return model;
+  }
+
+  static void assignModel(model_t &model, int keyBegin, int keyEnd, char val) {
+    for (int k = keyBegin; k < keyEnd; ++k) {
+      model[k - kKeyMin] = val;
+    }
+  }
+
+  // canonical: no breakpoint repeats the value in effect before it
+  template <typename V> static void expectCanonical(interval_map<int, V> const &m) {
+    V const *val_prev = &m.m_valBegin;
+    for (auto const &[key, val] : m.m_map) {
+      EXPECT_FALSE(val == *val_prev) << "redundant breakpoint at key " << key;
+      val_prev = &val;
+    }
+  }
+
+  template <typename V, typename Model>
+  static void expectMatchesModel(interval_map<int, V> const &m, Model const &model) {
+    for (int k = kKeyMin; k < kKeyMax; ++k) {
+      EXPECT_EQ(m[k], model[k - kKeyMin]) << "at key " << k;
+    }
+  }
+
+  interval_map_t randomMap(model_t &model) {
+    const char valBegin = randomValue();
+    interval_map_t m{valBegin};
+    model = makeModel(valBegin);
+    const int assigns = std::uniform_int_distribution<int>(0, 8)(gen_);
+    for (int i = 0; i < assigns; ++i) {
+      const int keyBegin = randomKey(), keyEnd = randomKey();
+      const char val = randomValue();
+      m.assign(keyBegin, keyEnd, val);
+      assignModel(model, keyBegin, keyEnd, val);
+    }
+    return m;
+  }
+
+  std::mt19937 gen_;
+};
+
+TEST_P(IntervalMapFuzzTest, AssignMatchesModel) {
+  const char valBegin = randomValue();
+  interval_map_t m{valBegin};
+  auto model = makeModel(valBegin);
+
+  for (int i = 0; i < kIterations && !HasFailure(); ++i) {
+    // empty and reversed intervals are drawn too, they must do nothing
+    const int keyBegin = randomKey(), keyEnd = randomKey();
+    const char val = randomValue();
+    SCOPED_TRACE(::testing::Message() << "iteration " << i << ": assign("
+                                      << keyBegin << ", " << keyEnd << ", '"
+                                      << val << "')");
+    m.assign(keyBegin, keyEnd, val);
+    assignModel(model, keyBegin, keyEnd, val);
+
+    expectMatchesModel(m, model);
+    expectCanonical(m);
+  }
+}
+
+TEST_P(IntervalMapFuzzTest, AssignOverloadsMatchModel) {
+  // heap allocated values, so reused and moved nodes are exercised
+  const auto makeValue = [](char c) { return std::string(32, c); };
+  interval_map<int, std::string> m{makeValue('A')};
+  std::array<std::string, kKeyMax - kKeyMin> model;
+  model.fill(makeValue('A'));
+
+  for (int i = 0; i < kIterations && !HasFailure(); ++i) {
+    const int keyBegin = randomKey(), keyEnd = randomKey();
+    const char c = randomValue();
+    const int overload = std::uniform_int_distribution<int>(0, 2)(gen_);
+    SCOPED_TRACE(::testing::Message() << "iteration " << i << ": overload "
+                                      << overload << " (" << keyBegin << ", "
+                                      << keyEnd << ", '" << c << "')");
+    if (overload == 0) {
+      const auto val = makeValue(c);
+      m.assign(keyBegin, keyEnd, val);
+    } else if (overload == 1) {
+      m.assign(keyBegin, keyEnd, makeValue(c));
+    } else {
+      m.emplace(keyBegin, keyEnd, 32, c);
+    }
+    for (int k = keyBegin; k < keyEnd; ++k) {
+      model[k - kKeyMin] = makeValue(c);
+    }
+
+    expectMatchesModel(m, model);
+    expectCanonical(m);
+  }
+}
+
+TEST_P(IntervalMapFuzzTest, MergeMatchesModel) {
+  const auto combine = [](char a, char b) { return a < b ? a : b; };
+
+  for (int i = 0; i < kIterations / 10 && !HasFailure(); ++i) {
+    SCOPED_TRACE(::testing::Message() << "iteration " << i);
+    model_t model_a, model_b;
+    const auto a = randomMap(model_a);
+    const auto b = randomMap(model_b);
+    const auto m = merge(a, b, combine);
+
+    model_t model;
+    for (std::size_t k = 0; k < model.size(); ++k) {
+      model[k] = combine(model_a[k], model_b[k]);
+    }
+    expectMatchesModel(m, model);
+    expectCanonical(m);
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Seeds, IntervalMapFuzzTest,
+                         ::testing::Values(1u, 42u, 5544u, 123456789u));
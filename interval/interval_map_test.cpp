@@ -1,19 +1,22 @@
 #include "interval_map.hpp"
+#include <algorithm>
+#include <memory_resource>
+#include <string>
 #include <gtest/gtest.h>
 
 class IntervalMapTest : public ::testing::Test {
 protected:
   void SetUp() override {
     EXPECT_EQ(getMapFor("m0").size(), 0);
-    m1.assign(2, 3, 'Z'); // size 1
-    EXPECT_EQ(getMapFor("m1").size(), 1);
+    m1.assign(2, 3, 'Z'); // size 2: begin and end breakpoint
+    EXPECT_EQ(getMapFor("m1").size(), 2);
     m2.assign(2, 4, 'Z'); // size 2
-    m2.assign(6, 8, 'Z'); // size 2
-    EXPECT_EQ(getMapFor("m2").size(), 2);
-    m3.assign(2, 3, 'X'); // size 3
-    m3.assign(5, 7, 'Y');
-    m3.assign(9, 12, 'Z');
-    EXPECT_EQ(getMapFor("m3").size(), 3);
+    m2.assign(6, 8, 'Z'); // size 4
+    EXPECT_EQ(getMapFor("m2").size(), 4);
+    m3.assign(2, 3, 'X'); // size 2
+    m3.assign(5, 7, 'Y'); // size 4
+    m3.assign(9, 12, 'Z'); // size 6
+    EXPECT_EQ(getMapFor("m3").size(), 6);
   }
 
   using interval_map_t = interval_map<int, char>;
@@ -33,6 +36,19 @@ protected:
       return m3.m_map;
     }
   };
+
+  // build a map directly from a canonical breakpoint sequence
+  template <typename V>
+  interval_map<int, V> makeMap(V valBegin, std::map<int, V> breakpoints) {
+    interval_map<int, V> m{valBegin};
+    m.m_map = std::move(breakpoints);
+    return m;
+  }
+  template <typename V>
+  std::map<int, V> getMap(interval_map<int, V> const &m) {
+    return m.m_map;
+  }
+
   interval_map_t m0{'A'};
   interval_map_t m1{'A'};
   interval_map_t m2{'A'};
@@ -43,22 +59,25 @@ TEST_F(IntervalMapTest, IntervalValueBeginMx) {
   EXPECT_EQ(m0[-2], 'A');
   EXPECT_EQ(m0[20], 'A');
   EXPECT_EQ(m1[-2], 'A');
-  EXPECT_EQ(m1[20], 'Z');
+  EXPECT_EQ(m1[2], 'Z');
+  EXPECT_EQ(m1[20], 'A');
   EXPECT_EQ(m2[-2], 'A');
-  EXPECT_EQ(m2[20], 'Z');
+  EXPECT_EQ(m2[7], 'Z');
+  EXPECT_EQ(m2[20], 'A');
 }
 
 TEST_F(IntervalMapTest, AssignUpdateFirstEntry) {
   m2.assign(1, 2, 'I');
-  EXPECT_EQ(getMapFor("m2").size(), 3);
+  EXPECT_EQ(getMapFor("m2").size(), 5);
   EXPECT_EQ(m2[1], 'I');
 }
 
 TEST_F(IntervalMapTest, AssignUpdateLastEntry) {
   m3.assign(12, 15, 'I');
-  EXPECT_EQ(getMapFor("m3").size(), 4);
-  EXPECT_EQ(m3[15], 'I');
-  EXPECT_EQ(m3[26], 'I');
+  EXPECT_EQ(getMapFor("m3").size(), 7);
+  EXPECT_EQ(m3[14], 'I');
+  EXPECT_EQ(m3[15], 'A');
+  EXPECT_EQ(m3[26], 'A');
   EXPECT_EQ(m3[11], 'Z');
 }
 
@@ -66,10 +85,144 @@ TEST_F(IntervalMapTest, AssignFirstEntrySameValue) {
   m0.assign(0, 1, 'A');
   EXPECT_EQ(getMapFor("m0").size(), 0);
   m1.assign(0, 1, 'A');
-  EXPECT_EQ(getMapFor("m1").size(), 1);
+  EXPECT_EQ(getMapFor("m1").size(), 2);
 }
 
 TEST_F(IntervalMapTest, AssignUpperboundCheck) {
   m3.assign(10, 11, 'Z');
-  EXPECT_EQ(getMapFor("m1").size(), 1);
+  EXPECT_EQ(getMapFor("m3").size(), 6);
+}
+
+TEST_F(IntervalMapTest, AssignValueStoredInMap) {
+  // the value assigned is erased from the map by the assignment itself
+  auto m = makeMap<std::string>("begin", {{10, std::string(64, 'x')},
+                                          {20, "end"}});
+  m.assign(5, 10, m[15]);
+  EXPECT_EQ(getMap(m), (std::map<int, std::string>{{5, std::string(64, 'x')},
+                                                    {20, "end"}}));
+  m.assign(0, 30, m[0]);
+  EXPECT_EQ(getMap(m), (std::map<int, std::string>{{30, "end"}}));
+  EXPECT_EQ(m[25], "begin");
+}
+
+TEST_F(IntervalMapTest, MergeEmptyMaps) {
+  auto m = merge(m0, interval_map_t{'B'},
+                 [](char a, char b) { return std::max(a, b); });
+  EXPECT_EQ(getMap(m).size(), 0);
+  EXPECT_EQ(m[0], 'B');
+}
+
+TEST_F(IntervalMapTest, MergeOverlayPatch) {
+  // patch layer: '\0' means "keep the base value"
+  auto base = makeMap<char>('A', {{2, 'X'}, {5, 'A'}, {9, 'Z'}});
+  auto patch = makeMap<char>('\0', {{4, 'P'}, {10, '\0'}});
+  auto m = merge(base, patch, [](char b, char p) { return p ? p : b; });
+
+  const std::map<int, char> expected{{2, 'X'}, {4, 'P'}, {10, 'Z'}};
+  EXPECT_EQ(getMap(m), expected);
+  EXPECT_EQ(m[1], 'A');
+  EXPECT_EQ(m[3], 'X');
+  EXPECT_EQ(m[9], 'P');
+  EXPECT_EQ(m[42], 'Z');
+}
+
+TEST_F(IntervalMapTest, MergeSharedBreakpointsStayCanonical) {
+  auto a = makeMap<int>(0, {{2, 1}, {6, 0}});
+  auto b = makeMap<int>(1, {{2, 0}, {6, 1}});
+  // a + b is 1 everywhere, so no breakpoint may survive
+  auto m = merge(a, b, std::plus<int>{});
+  EXPECT_EQ(getMap(m).size(), 0);
+  EXPECT_EQ(m[4], 1);
+}
+
+TEST_F(IntervalMapTest, MergeDifferentValueTypes) {
+  auto a = makeMap<int>(0, {{0, 3}, {10, 0}});
+  auto b = makeMap<char>('a', {{5, 'b'}});
+  auto m = merge(a, b, [](int n, char c) { return std::string(n, c); });
+
+  EXPECT_EQ(getMap(m).size(), 3);
+  EXPECT_EQ(m[-1], "");
+  EXPECT_EQ(m[0], "aaa");
+  EXPECT_EQ(m[7], "bbb");
+  EXPECT_EQ(m[10], "");
+}
+
+// counts the copies made of a value, moves are free
+struct CopyCounted {
+  int val;
+  int *copies;
+  CopyCounted(int v, int *c) : val(v), copies(c) {}
+  CopyCounted(CopyCounted const &o) : val(o.val), copies(o.copies) {
+    ++*copies;
+  }
+  CopyCounted(CopyCounted &&) = default;
+  CopyCounted &operator=(CopyCounted const &o) {
+    val = o.val;
+    copies = o.copies;
+    ++*copies;
+    return *this;
+  }
+  CopyCounted &operator=(CopyCounted &&) = default;
+  bool operator==(CopyCounted const &o) const { return val == o.val; }
+};
+
+TEST_F(IntervalMapTest, AssignRvalueDoesNotCopy) {
+  int copies = 0;
+  interval_map<int, CopyCounted> m{CopyCounted{0, &copies}};
+  m.assign(0, 10, CopyCounted{1, &copies}); // end breakpoint copies the 0
+  EXPECT_EQ(copies, 1);
+  m.assign(0, 10, CopyCounted{2, &copies}); // reuses both breakpoints
+  m.assign(2, 10, CopyCounted{3, &copies}); // new breakpoint, moved in
+  m.emplace(2, 10, 4, &copies);             // reuses the breakpoint at 2
+  EXPECT_EQ(copies, 1);
+  EXPECT_EQ(m[1].val, 2);
+  EXPECT_EQ(m[9].val, 4);
+  EXPECT_EQ(m[10].val, 0);
+}
+
+// memory_resource counting the allocations it forwards upstream
+class CountingResource : public std::pmr::memory_resource {
+public:
+  int allocations = 0;
+
+private:
+  void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+    ++allocations;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+  void do_deallocate(void *p, std::size_t bytes,
+                     std::size_t alignment) override {
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+  bool do_is_equal(std::pmr::memory_resource const &other)
+      const noexcept override {
+    return this == &other;
+  }
+};
+
+TEST_F(IntervalMapTest, AssignReusesNodes) {
+  CountingResource resource;
+  pmr::interval_map<int, char> m{'A', &resource};
+  m.assign(0, 10, 'B');
+  m.assign(2, 5, 'C');
+  EXPECT_EQ(resource.allocations, 4);
+
+  // steady state: the breakpoints move, their number does not grow
+  m.assign(2, 5, 'D');
+  m.assign(1, 6, 'E');
+  m.assign(0, 3, 'F');
+  m.assign(3, 10, 'G');
+  EXPECT_EQ(resource.allocations, 4);
+  EXPECT_EQ(m[2], 'F');
+  EXPECT_EQ(m[9], 'G');
+  EXPECT_EQ(m[10], 'A');
+}
+
+TEST_F(IntervalMapTest, MergeUsesAllocatorOfFirstMap) {
+  CountingResource resource;
+  pmr::interval_map<int, char> a{'A', &resource};
+  a.assign(0, 10, 'B');
+  auto m = merge(a, m3, [](char x, char y) { return std::max(x, y); });
+  EXPECT_EQ(m.get_allocator().resource(), &resource);
+  EXPECT_EQ(m[6], 'Y');
 }
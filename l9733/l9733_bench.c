@@ -0,0 +1,298 @@
+/* Throughput benchmark of the L9733 driver against l9733_model.
+ * Reports commands per second through the driver, and the bus bytes spent
+ * per output update.
+ */
+#define _POSIX_C_SOURCE 200112L
+
+#include "l9733_model.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_ITERATIONS (10000000UL)
+
+static double bench_now(void)
+{
+        struct timespec ts;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void bench_report(const char *name, const struct l9733_model *model,
+                         unsigned long updates, double seconds)
+{
+        printf("%-26s %12.0f calls/s %6.2f bytes/update "
+               "%10lu transactions %10lu commands\n",
+               name, (double)updates / seconds,
+               (double)model->bytes / (double)updates, model->transactions,
+               model->commands);
+}
+
+/* switch outputs on one after another, one command per output change */
+static void bench_write_outputs(void)
+{
+        struct l9733_model model;
+        struct spi_t dev;
+        struct l9733_input_command cmd = {
+                L9733_COMMAND_KEYWORD, L9733_COMMAND_OUTPUT, 0
+        };
+        unsigned long i;
+        double start;
+
+        l9733_model_init(&model);
+        l9733_model_attach(&model, &dev);
+        if (l9733_initialize_spi(&dev) != 0)
+                exit(EXIT_FAILURE);
+
+        start = bench_now();
+        for (i = 0; i < BENCH_ITERATIONS; i++) {
+                cmd.output_mode_mask ^=
+                        L9733_OUTPUT_STATE_n(i % L9733_NUMBER_OF_OUTPUTS,
+                                             L9733_COMMAND_SET_OUTPUT_ON);
+                if (l9733_write_spi(&dev, cmd) != 0)
+                        exit(EXIT_FAILURE);
+        }
+        bench_report("l9733_write_spi", &model, BENCH_ITERATIONS,
+                     bench_now() - start);
+        if (model.outputs != cmd.output_mode_mask)
+                exit(EXIT_FAILURE);
+}
+
+/* the frames of bench_write_outputs, encoded at build time */
+static const uint16_t bench_frames[L9733_NUMBER_OF_OUTPUTS] = {
+        L9733_FRAME_OUTPUT(L9733_OUTPUT_STATE(0, 1)),
+        L9733_FRAME_OUTPUT(L9733_OUTPUT_STATE(0, 1) | L9733_OUTPUT_STATE(1, 1)),
+        L9733_FRAME_OUTPUT(0x07), L9733_FRAME_OUTPUT(0x0f),
+        L9733_FRAME_OUTPUT(0x1f), L9733_FRAME_OUTPUT(0x3f),
+        L9733_FRAME_OUTPUT(0x7f), L9733_FRAME_OUTPUT(0xff)
+};
+
+/* the same output changes as bench_write_outputs, from constant frames */
+static void bench_write_frames(void)
+{
+        struct l9733_model model;
+        struct spi_t dev;
+        unsigned long i;
+        double start;
+
+        l9733_model_init(&model);
+        l9733_model_attach(&model, &dev);
+
+        start = bench_now();
+        for (i = 0; i < BENCH_ITERATIONS; i++) {
+                if (l9733_write_frame(&dev, bench_frames[i %
+                                      L9733_NUMBER_OF_OUTPUTS]) != 0)
+                        exit(EXIT_FAILURE);
+        }
+        bench_report("l9733_write_frame", &model, BENCH_ITERATIONS,
+                     bench_now() - start);
+        if (model.outputs != 0xff || model.rejected != 0)
+                exit(EXIT_FAILURE);
+}
+
+/* each round changes every output of a control loop one by one, and also
+ * repeats the protection setting: direct writes send a frame for each call,
+ * the cached device coalesces the outputs and skips the repeated setting
+ */
+static void bench_control_loop(int cached)
+{
+        struct l9733_model model;
+        struct spi_t dev;
+        struct l9733_device l9733;
+        struct l9733_input_command cmd = {
+                L9733_COMMAND_KEYWORD, L9733_COMMAND_OUTPUT, 0
+        };
+        const struct l9733_input_command protection = {
+                L9733_COMMAND_KEYWORD, L9733_COMMAND_PROTECTION, 0xff
+        };
+        unsigned long i, updates = 0;
+        uint8_t n;
+        double start;
+
+        l9733_model_init(&model);
+        l9733_model_attach(&model, &dev);
+        l9733_device_init(&l9733, &dev);
+
+        start = bench_now();
+        for (i = 0; i < BENCH_ITERATIONS / L9733_NUMBER_OF_OUTPUTS; i++) {
+                for (n = 0; n < L9733_NUMBER_OF_OUTPUTS; n++, updates++) {
+                        const uint8_t state = (uint8_t)((i + n) & 1);
+
+                        if (cached) {
+                                l9733_device_stage(&l9733, L9733_COMMAND_OUTPUT,
+                                                   n, state);
+                                continue;
+                        }
+                        cmd.output_mode_mask =
+                                (uint8_t)((cmd.output_mode_mask & ~(1u << n)) |
+                                          L9733_OUTPUT_STATE_n(n, state));
+                        l9733_write_spi(&dev, cmd);
+                }
+                if (cached) {
+                        l9733_device_write(&l9733, protection);
+                        l9733_device_flush(&l9733);
+                } else {
+                        l9733_write_spi(&dev, protection);
+                }
+                updates++;
+        }
+        bench_report(cached ? "control loop, cached" : "control loop, direct",
+                     &model, updates, bench_now() - start);
+        if (model.outputs != (cached ? l9733.shadow[L9733_COMMAND_OUTPUT]
+                                     : cmd.output_mode_mask))
+                exit(EXIT_FAILURE);
+}
+
+#define BENCH_CHAIN_LENGTH (8)
+
+/* update the outputs of BENCH_CHAIN_LENGTH chips and read their faults:
+ * with separate chip selects this takes a transaction per chip, a daisy
+ * chain does it in one
+ */
+static void bench_chain(int chained)
+{
+        struct l9733_model chips[BENCH_CHAIN_LENGTH];
+        struct l9733_model_chain chain = { chips, BENCH_CHAIN_LENGTH };
+        struct spi_t devs[BENCH_CHAIN_LENGTH];
+        struct l9733_input_command cmds[BENCH_CHAIN_LENGTH];
+        int16_t faults[BENCH_CHAIN_LENGTH];
+        struct l9733_model total;
+        unsigned long i, updates = 0;
+        size_t k;
+        double start, seconds;
+
+        for (k = 0; k < BENCH_CHAIN_LENGTH; k++) {
+                l9733_model_init(&chips[k]);
+                l9733_model_set_fault(&chips[k], (uint8_t)k,
+                                      L9733_FAULT_SHORT_CIRCUIT);
+                l9733_model_attach(&chips[k], &devs[k]);
+                cmds[k].keyword = L9733_COMMAND_KEYWORD;
+                cmds[k].mode = L9733_COMMAND_OUTPUT;
+        }
+        if (chained)
+                l9733_model_chain_attach(&chain, &devs[0]);
+
+        start = bench_now();
+        for (i = 0; i < BENCH_ITERATIONS / BENCH_CHAIN_LENGTH; i++) {
+                for (k = 0; k < BENCH_CHAIN_LENGTH; k++)
+                        cmds[k].output_mode_mask = (uint8_t)(i + k);
+                if (chained) {
+                        l9733_chain_write_spi(&devs[0], cmds, faults,
+                                              BENCH_CHAIN_LENGTH);
+                } else {
+                        for (k = 0; k < BENCH_CHAIN_LENGTH; k++)
+                                l9733_write_spi(&devs[k], cmds[k]);
+                }
+                updates += BENCH_CHAIN_LENGTH;
+        }
+
+        seconds = bench_now() - start;
+
+        /* report the bus traffic of all chips, the chips of a chain all see
+         * the same transactions */
+        l9733_model_init(&total);
+        for (k = 0; k < BENCH_CHAIN_LENGTH; k++) {
+                if (chips[k].outputs != cmds[k].output_mode_mask)
+                        exit(EXIT_FAILURE);
+                if (chained && L9733_FAULT_STATUS_n(k, faults[k]) !=
+                               L9733_FAULT_SHORT_CIRCUIT)
+                        exit(EXIT_FAILURE);
+                total.commands += chips[k].commands;
+                if (!chained || k == 0) {
+                        total.transactions += chips[k].transactions;
+                        total.bytes += chips[k].bytes;
+                }
+        }
+        bench_report(chained ? "8 chips, daisy chain" : "8 chips, one CS each",
+                     &total, updates, seconds);
+}
+
+static void bench_read_faults(void)
+{
+        struct l9733_model model;
+        struct spi_t dev;
+        unsigned long i, faults = 0;
+        double start;
+
+        l9733_model_init(&model);
+        l9733_model_attach(&model, &dev);
+        l9733_model_set_fault(&model, 3, L9733_FAULT_OPEN_LOAD);
+
+        start = bench_now();
+        for (i = 0; i < BENCH_ITERATIONS; i++) {
+                const int16_t reg = l9733_read_fault_register(&dev);
+
+                faults += L9733_FAULT_STATUS_n(3, reg) != L9733_FAULT_NO_FAULT;
+        }
+        bench_report("l9733_read_fault_register", &model, BENCH_ITERATIONS,
+                     bench_now() - start);
+        if (faults != BENCH_ITERATIONS)
+                exit(EXIT_FAILURE);
+}
+
+static volatile int bench_polling;
+
+/* stands in for the timer interrupt polling the fault register */
+static void *bench_poll_thread(void *arg)
+{
+        struct l9733_fault_poller *poller = arg;
+
+        while (bench_polling)
+                l9733_fault_poll(poller);
+        return NULL;
+}
+
+/* the control loop checks output 3 through snapshots, while a thread keeps
+ * polling the fault register in the background
+ */
+static void bench_fault_snapshot(void)
+{
+        struct l9733_model model;
+        struct spi_t dev;
+        struct l9733_fault_poller poller;
+        struct l9733_fault_state state;
+        pthread_t thread;
+        unsigned long i, faults = 0;
+        double start, seconds;
+
+        l9733_model_init(&model);
+        l9733_model_attach(&model, &dev);
+        l9733_model_set_fault(&model, 3, L9733_FAULT_OPEN_LOAD);
+        l9733_fault_poller_init(&poller, &dev);
+        l9733_fault_poll(&poller);
+
+        bench_polling = 1;
+        if (pthread_create(&thread, NULL, bench_poll_thread, &poller) != 0)
+                exit(EXIT_FAILURE);
+        start = bench_now();
+        for (i = 0; i < BENCH_ITERATIONS; i++) {
+                l9733_fault_snapshot(&poller, &state);
+                faults += state.output[3] == L9733_FAULT_OPEN_LOAD &&
+                          state.faulty == (1u << 3);
+        }
+        seconds = bench_now() - start;
+        bench_polling = 0;
+        pthread_join(thread, NULL);
+
+        printf("%-26s %12.0f calls/s, %lu polls in the background\n",
+               "l9733_fault_snapshot", (double)BENCH_ITERATIONS / seconds,
+               (unsigned long)(poller.sequence / 2));
+        if (faults != BENCH_ITERATIONS)
+                exit(EXIT_FAILURE);
+}
+
+int main(void)
+{
+        bench_write_outputs();
+        bench_write_frames();
+        bench_control_loop(0);
+        bench_control_loop(1);
+        bench_chain(0);
+        bench_chain(1);
+        bench_read_faults();
+        bench_fault_snapshot();
+        return 0;
+}
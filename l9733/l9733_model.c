@@ -0,0 +1,101 @@
+#include "l9733_model.h"
+
+#include <string.h>
+
+void l9733_model_init(struct l9733_model *model)
+{
+        memset(model, 0, sizeof(*model));
+}
+
+void l9733_model_attach(struct l9733_model *model, struct spi_t *dev)
+{
+        dev->transfer = l9733_model_transfer;
+        dev->ctx = model;
+        dev->busy = 0;
+}
+
+void l9733_model_set_fault(struct l9733_model *model, uint8_t output_n,
+                           enum l9733_output_fault fault)
+{
+        model->faults &= (uint16_t)~(0x3u << (2 * output_n));
+        model->faults |= (uint16_t)((unsigned)fault << (2 * output_n));
+}
+
+/* l9733_model_execute CS went to logic 1 with frame in the shift register */
+static void l9733_model_execute(struct l9733_model *model, uint16_t frame)
+{
+        const uint8_t mask = (uint8_t)frame;
+
+        if ((frame >> 12) != L9733_COMMAND_KEYWORD) {
+                model->rejected++;
+                return;
+        }
+        switch ((frame >> 8) & 0xf) {
+        case L9733_COMMAND_MODE_OUTPUT:
+                model->outputs = mask;
+                break;
+        case L9733_COMMAND_MODE_DIAGNOSTICS:
+                model->latch = mask;
+                break;
+        case L9733_COMMAND_MODE_PROTECTION:
+                model->protection = mask;
+                break;
+        default:
+                model->rejected++;
+                return;
+        }
+        model->commands++;
+}
+
+/* l9733_model_shift one CS window over the chips of a chain */
+static int l9733_model_shift(struct l9733_model *chips, size_t n,
+                             const uint8_t *tx, uint8_t *rx, size_t len)
+{
+        size_t i, k;
+
+        if (n == 0 || len == 0 || len % L9733_FRAME_BYTES != 0)
+                return ERR_L9733_FAIL_SPI_WRITE;
+
+        /* CS to logic 0: the fault registers are loaded for shifting out */
+        for (k = 0; k < n; k++) {
+                chips[k].shift = chips[k].faults;
+                chips[k].transactions++;
+                chips[k].bytes += len;
+        }
+        for (i = 0; i < len; i += L9733_FRAME_BYTES) {
+                /* the last chip drives the MC's DO, each chip shifts into
+                 * the next one */
+                rx[i] = (uint8_t)(chips[n - 1].shift >> 8);
+                rx[i + 1] = (uint8_t)chips[n - 1].shift;
+                for (k = n - 1; k > 0; k--)
+                        chips[k].shift = chips[k - 1].shift;
+                chips[0].shift = (uint16_t)((tx[i] << 8) | tx[i + 1]);
+        }
+
+        /* CS to logic 1 */
+        for (k = 0; k < n; k++)
+                l9733_model_execute(&chips[k], chips[k].shift);
+        return 0;
+}
+
+int l9733_model_transfer(void *ctx, const uint8_t *tx, uint8_t *rx,
+                         size_t len)
+{
+        return l9733_model_shift(ctx, 1, tx, rx, len);
+}
+
+void l9733_model_chain_attach(struct l9733_model_chain *chain,
+                              struct spi_t *dev)
+{
+        dev->transfer = l9733_model_chain_transfer;
+        dev->ctx = chain;
+        dev->busy = 0;
+}
+
+int l9733_model_chain_transfer(void *ctx, const uint8_t *tx, uint8_t *rx,
+                               size_t len)
+{
+        struct l9733_model_chain *chain = ctx;
+
+        return l9733_model_shift(chain->chips, chain->length, tx, rx, len);
+}
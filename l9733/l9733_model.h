@@ -0,0 +1,77 @@
+#ifndef L9733_MODEL_H
+#define L9733_MODEL_H
+
+#include "spi_l9733.h"
+
+/* Software model of an L9733, to run the driver on a host without hardware.
+ *
+ * The chip is modelled as its 16 bit SPI shift register:
+ * - CS to logic 0 loads the fault register into the shift register
+ * - every 16 SCLK cycles the shift register is output on DO while the frame
+ *   on DI is shifted in, so DO first carries the fault register and then
+ *   echoes DI delayed by 16 SCLK cycles
+ * - CS to logic 1 executes the frame left in the shift register, if it
+ *   starts with L9733_COMMAND_KEYWORD and has a known mode
+ * A daisy chain connects these shift registers one after another.
+ */
+
+/* l9733_model state of one modelled chip
+ * @outputs: output on/off state, output 8 is MSB:bit 7
+ * @latch: diagnostics latch mode for each output
+ * @protection: overcurrent protection for each output
+ * @faults: fault register, 2 bits per output, \see L9733_FAULT_STATUS_n
+ * @shift: the SPI shift register
+ * @transactions: number of CS windows seen
+ * @bytes: number of bytes shifted in on DI
+ * @commands: number of frames executed
+ * @rejected: number of frames ignored (bad key-word or mode)
+ */
+struct l9733_model {
+        uint8_t outputs;
+        uint8_t latch;
+        uint8_t protection;
+        uint16_t faults;
+        uint16_t shift;
+
+        unsigned long transactions;
+        unsigned long bytes;
+        unsigned long commands;
+        unsigned long rejected;
+};
+
+/* l9733_model_init reset the model, like the RES pin: all outputs off */
+void l9733_model_init(struct l9733_model *model);
+
+/* l9733_model_attach point an SPI controller at the model
+ * @dev the controller to set up, pass it to l9733_initialize_spi afterwards
+ */
+void l9733_model_attach(struct l9733_model *model, struct spi_t *dev);
+
+/* l9733_model_transfer spi_transfer_fn of the model, ctx is the model
+ * @return error status, the length must be a multiple of L9733_FRAME_BYTES
+ */
+int l9733_model_transfer(void *ctx, const uint8_t *tx, uint8_t *rx,
+                         size_t len);
+
+/* l9733_model_chain a daisy chain of modelled chips
+ * @chips: the chips, chip 0 is connected to the MC's DI
+ * @length: number of chips
+ */
+struct l9733_model_chain {
+        struct l9733_model *chips;
+        size_t length;
+};
+
+/* l9733_model_chain_attach point an SPI controller at a modelled chain */
+void l9733_model_chain_attach(struct l9733_model_chain *chain,
+                              struct spi_t *dev);
+
+/* l9733_model_chain_transfer spi_transfer_fn of a chain, ctx is the chain */
+int l9733_model_chain_transfer(void *ctx, const uint8_t *tx, uint8_t *rx,
+                               size_t len);
+
+/* l9733_model_set_fault inject a fault for output n (0 based) */
+void l9733_model_set_fault(struct l9733_model *model, uint8_t output_n,
+                           enum l9733_output_fault fault);
+
+#endif /* L9733_MODEL_H */
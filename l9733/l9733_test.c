@@ -0,0 +1,632 @@
+/* Tests of the L9733 driver against l9733_model, run with make test.
+ * Every failed check is reported, the exit status is the test result.
+ */
+#include "l9733_model.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static int test_failures;
+
+#define TEST_CHECK(cond) \
+        do { \
+                if (!(cond)) { \
+                        printf("%s:%d: %s: check failed: %s\n", __FILE__, \
+                               __LINE__, __func__, #cond); \
+                        test_failures++; \
+                } \
+        } while (0)
+
+/* spi_transfer_fn of a controller whose every transfer fails */
+static int test_transfer_fail(void *ctx, const uint8_t *tx, uint8_t *rx,
+                              size_t len)
+{
+        (void)ctx;
+        (void)tx;
+        (void)rx;
+        (void)len;
+        return -1;
+}
+
+static void test_encode_frame(void)
+{
+        struct l9733_input_command cmd = {
+                L9733_COMMAND_KEYWORD, L9733_COMMAND_OUTPUT, 0x81
+        };
+
+        TEST_CHECK(l9733_encode_frame(cmd) == 0xAC81);
+        cmd.mode = L9733_COMMAND_DIAGNOSTICS;
+        cmd.output_mode_mask = 0x0F;
+        TEST_CHECK(l9733_encode_frame(cmd) == 0xA30F);
+        cmd.mode = L9733_COMMAND_PROTECTION;
+        cmd.output_mode_mask = 0xFF;
+        TEST_CHECK(l9733_encode_frame(cmd) == 0xAAFF);
+        cmd.mode = (enum l9733_command_mode)L9733_NUMBER_OF_COMMAND_MODES;
+        TEST_CHECK(l9733_encode_frame(cmd) == ERR_L9733_INVALID_COMMAND);
+}
+
+/* encoded at build time, \see L9733_FRAME */
+static const uint16_t test_frames[] = {
+        L9733_FRAME_OUTPUT(L9733_OUTPUT_STATE(0, 1) | L9733_OUTPUT_STATE(7, 1)),
+        L9733_FRAME_DIAGNOSTICS(0x0F),
+        L9733_FRAME_PROTECTION(0xFF)
+};
+
+static void test_constant_frames(void)
+{
+        struct l9733_input_command cmd = {
+                L9733_COMMAND_KEYWORD, L9733_COMMAND_OUTPUT, 0x81
+        };
+
+        TEST_CHECK(test_frames[0] == 0xAC81);
+        TEST_CHECK(test_frames[0] == l9733_encode_frame(cmd));
+        cmd.mode = L9733_COMMAND_DIAGNOSTICS;
+        cmd.output_mode_mask = 0x0F;
+        TEST_CHECK(test_frames[1] == 0xA30F);
+        TEST_CHECK(test_frames[1] == l9733_encode_frame(cmd));
+        cmd.mode = L9733_COMMAND_PROTECTION;
+        cmd.output_mode_mask = 0xFF;
+        TEST_CHECK(test_frames[2] == 0xAAFF);
+        TEST_CHECK(test_frames[2] == l9733_encode_frame(cmd));
+
+        /* out of range states and masks fail to build, \see make test */
+        TEST_CHECK(L9733_OUTPUT_STATE(3, 1) == 0x08);
+        TEST_CHECK(L9733_OUTPUT_STATE(3, 0) == 0x00);
+        TEST_CHECK(L9733_FRAME_OUTPUT(0xFF) == 0xACFF);
+        TEST_CHECK(L9733_FRAME(L9733_COMMAND_MODE_DIAGNOSTICS, 0) == 0xA300);
+
+        /* bits reversed within each byte, the byte order is kept */
+        TEST_CHECK(L9733_BIT_REVERSE8(0x01) == 0x80);
+        TEST_CHECK(L9733_BIT_REVERSE8(0xAC) == 0x35);
+        TEST_CHECK(L9733_FRAME_MSB_FIRST(0xAC81) == 0x3581);
+        TEST_CHECK(L9733_FRAME_MSB_FIRST(0x0102) == 0x8040);
+        TEST_CHECK(L9733_FRAME_MSB_FIRST(
+                           L9733_FRAME_MSB_FIRST(test_frames[1])) ==
+                   test_frames[1]);
+}
+
+static void test_write_frame(void)
+{
+        struct l9733_model model;
+        struct spi_t dev = { NULL, NULL, 0 };
+        size_t i;
+
+        TEST_CHECK(l9733_write_frame(&dev, test_frames[0]) ==
+                   ERR_L9733_FAIL_SPI_WRITE);
+        l9733_model_init(&model);
+        l9733_model_attach(&model, &dev);
+        for (i = 0; i < sizeof(test_frames) / sizeof(test_frames[0]); i++)
+                TEST_CHECK(l9733_write_frame(&dev, test_frames[i]) == 0);
+        TEST_CHECK(model.outputs == 0x81 && model.latch == 0x0F);
+        TEST_CHECK(model.protection == 0xFF && model.commands == 3);
+}
+
+static void test_write_spi(void)
+{
+        struct l9733_model model;
+        struct spi_t dev;
+        struct l9733_input_command cmd = {
+                L9733_COMMAND_KEYWORD, L9733_COMMAND_OUTPUT,
+                L9733_OUTPUT_STATE_n(0, L9733_COMMAND_SET_OUTPUT_ON) |
+                L9733_OUTPUT_STATE_n(7, L9733_COMMAND_SET_OUTPUT_ON)
+        };
+
+        l9733_model_init(&model);
+        l9733_model_attach(&model, &dev);
+        TEST_CHECK(l9733_initialize_spi(&dev) == 0);
+        TEST_CHECK(l9733_write_spi(&dev, cmd) == 0);
+        TEST_CHECK(model.outputs == 0x81);
+        cmd.mode = L9733_COMMAND_PROTECTION;
+        cmd.output_mode_mask = 0x0F;
+        TEST_CHECK(l9733_write_spi(&dev, cmd) == 0);
+        TEST_CHECK(model.protection == 0x0F && model.outputs == 0x81);
+        TEST_CHECK(model.transactions == 2 && model.bytes == 4);
+        TEST_CHECK(model.commands == 2 && model.rejected == 0);
+}
+
+static void test_model_echoes_previous_frame(void)
+{
+        struct l9733_model model;
+        const uint8_t tx[] = { 0xAC, 0x0F, 0xAC, 0xF0 };
+        uint8_t rx[sizeof(tx)];
+
+        l9733_model_init(&model);
+        l9733_model_set_fault(&model, 0, L9733_FAULT_OVERCURRENT);
+        TEST_CHECK(l9733_model_transfer(&model, tx, rx, sizeof(tx)) == 0);
+        /* DO carries the fault register, then DI 16 SCLK cycles earlier */
+        TEST_CHECK(rx[0] == 0x00 && rx[1] == 0x03);
+        TEST_CHECK(rx[2] == 0xAC && rx[3] == 0x0F);
+        /* only the frame left in the shift register is executed */
+        TEST_CHECK(model.outputs == 0xF0 && model.commands == 1);
+        TEST_CHECK(l9733_model_transfer(&model, tx, rx, 3) != 0);
+}
+
+static void test_read_fault_register(void)
+{
+        struct l9733_model model;
+        struct spi_t dev;
+        int16_t faults;
+
+        l9733_model_init(&model);
+        l9733_model_attach(&model, &dev);
+        model.outputs = 0x5A;
+        l9733_model_set_fault(&model, 3, L9733_FAULT_OPEN_LOAD);
+        l9733_model_set_fault(&model, 7, L9733_FAULT_SHORT_CIRCUIT);
+
+        faults = l9733_read_fault_register(&dev);
+        TEST_CHECK(L9733_FAULT_STATUS_n(0, faults) == L9733_FAULT_NO_FAULT);
+        TEST_CHECK(L9733_FAULT_STATUS_n(3, faults) == L9733_FAULT_OPEN_LOAD);
+        TEST_CHECK(L9733_FAULT_STATUS_n(7, faults) ==
+                   L9733_FAULT_SHORT_CIRCUIT);
+        /* the NOP frame is ignored by the chip */
+        TEST_CHECK(model.outputs == 0x5A);
+        TEST_CHECK(model.commands == 0 && model.rejected == 1);
+}
+
+static void test_spi_errors(void)
+{
+        struct spi_t dev = { NULL, NULL, 0 };
+        const struct l9733_input_command cmd = {
+                L9733_COMMAND_KEYWORD, L9733_COMMAND_OUTPUT, 0x01
+        };
+
+        TEST_CHECK(l9733_initialize_spi(NULL) == ERR_L9733_FAIL_SPI_WRITE);
+        TEST_CHECK(l9733_initialize_spi(&dev) == ERR_L9733_FAIL_SPI_WRITE);
+        TEST_CHECK(l9733_write_spi(&dev, cmd) == ERR_L9733_FAIL_SPI_WRITE);
+        TEST_CHECK(l9733_read_fault_register(&dev) == ERR_L9733_FAIL_SPI_READ);
+
+        dev.transfer = test_transfer_fail;
+        TEST_CHECK(l9733_write_spi(&dev, cmd) == ERR_L9733_FAIL_SPI_WRITE);
+        TEST_CHECK(l9733_read_fault_register(&dev) == ERR_L9733_FAIL_SPI_READ);
+}
+
+static void test_device_skips_unchanged_writes(void)
+{
+        struct l9733_model model;
+        struct spi_t dev;
+        struct l9733_device l9733;
+        struct l9733_input_command cmd = {
+                L9733_COMMAND_KEYWORD, L9733_COMMAND_OUTPUT, 0x00
+        };
+
+        l9733_model_init(&model);
+        l9733_model_attach(&model, &dev);
+        l9733_device_init(&l9733, &dev);
+
+        /* the first write of a mode is always sent, even the reset state */
+        TEST_CHECK(l9733_device_write(&l9733, cmd) == 0);
+        TEST_CHECK(model.commands == 1);
+        TEST_CHECK(l9733_device_write(&l9733, cmd) == 0);
+        TEST_CHECK(model.commands == 1);
+        cmd.output_mode_mask = 0x0F;
+        TEST_CHECK(l9733_device_write(&l9733, cmd) == 0);
+        TEST_CHECK(model.commands == 2 && model.outputs == 0x0F);
+        /* each mode has its own shadow */
+        cmd.mode = L9733_COMMAND_DIAGNOSTICS;
+        TEST_CHECK(l9733_device_write(&l9733, cmd) == 0);
+        TEST_CHECK(model.commands == 3 && model.latch == 0x0F);
+
+        /* after l9733_reset the chip state is unknown again */
+        l9733_device_invalidate(&l9733);
+        TEST_CHECK(l9733_device_write(&l9733, cmd) == 0);
+        TEST_CHECK(model.commands == 4);
+}
+
+static void test_device_rejects_bad_keyword(void)
+{
+        struct l9733_model model;
+        struct spi_t dev;
+        struct l9733_device l9733;
+        struct l9733_input_command cmd = {
+                0, L9733_COMMAND_OUTPUT, 0x0F
+        };
+
+        l9733_model_init(&model);
+        l9733_model_attach(&model, &dev);
+        l9733_device_init(&l9733, &dev);
+
+        TEST_CHECK(l9733_device_write(&l9733, cmd) ==
+                   ERR_L9733_INVALID_COMMAND);
+        TEST_CHECK(model.transactions == 0);
+        cmd.keyword = L9733_COMMAND_KEYWORD;
+        TEST_CHECK(l9733_device_write(&l9733, cmd) == 0);
+        TEST_CHECK(model.outputs == 0x0F && model.rejected == 0);
+        TEST_CHECK(l9733.shadow[L9733_COMMAND_OUTPUT] == 0x0F);
+}
+
+static void test_device_write_error_invalidates_shadow(void)
+{
+        struct l9733_model model;
+        struct spi_t dev;
+        struct l9733_device l9733;
+        const struct l9733_input_command cmd = {
+                L9733_COMMAND_KEYWORD, L9733_COMMAND_OUTPUT, 0x0F
+        };
+
+        l9733_model_init(&model);
+        l9733_model_attach(&model, &dev);
+        l9733_device_init(&l9733, &dev);
+        TEST_CHECK(l9733_device_write(&l9733, cmd) == 0);
+
+        /* the chip may or may not have taken the frame */
+        dev.transfer = test_transfer_fail;
+        TEST_CHECK(l9733_device_write(&l9733, cmd) == 0); /* unchanged */
+        l9733_device_stage(&l9733, L9733_COMMAND_OUTPUT, 4, 1);
+        TEST_CHECK(l9733_device_flush(&l9733) == ERR_L9733_FAIL_SPI_WRITE);
+        TEST_CHECK(!(l9733.shadow_valid & (1u << L9733_COMMAND_OUTPUT)));
+        TEST_CHECK(l9733.pending_mask[L9733_COMMAND_OUTPUT] == 0x10);
+
+        /* the staged change is sent once the bus works again */
+        dev.transfer = l9733_model_transfer;
+        TEST_CHECK(l9733_device_flush(&l9733) == 0);
+        TEST_CHECK(model.outputs == 0x1F && model.commands == 2);
+        TEST_CHECK(l9733.pending_mask[L9733_COMMAND_OUTPUT] == 0);
+
+        /* a failed write is repeated, even with the same mask */
+        dev.transfer = test_transfer_fail;
+        TEST_CHECK(l9733_device_write(&l9733, cmd) ==
+                   ERR_L9733_FAIL_SPI_WRITE);
+        dev.transfer = l9733_model_transfer;
+        TEST_CHECK(l9733_device_write(&l9733, cmd) == 0);
+        TEST_CHECK(model.outputs == 0x0F && model.commands == 3);
+        TEST_CHECK(l9733_device_write(&l9733, cmd) == 0);
+        TEST_CHECK(model.commands == 3);
+}
+
+static void test_device_flush_after_failed_write(void)
+{
+        struct l9733_model model;
+        struct spi_t dev;
+        struct l9733_device l9733;
+        struct l9733_input_command cmd = {
+                L9733_COMMAND_KEYWORD, L9733_COMMAND_OUTPUT, 0x0F
+        };
+
+        l9733_model_init(&model);
+        l9733_model_attach(&model, &dev);
+        l9733_device_init(&l9733, &dev);
+        TEST_CHECK(l9733_device_write(&l9733, cmd) == 0);
+
+        dev.transfer = test_transfer_fail;
+        cmd.output_mode_mask = 0xF0;
+        TEST_CHECK(l9733_device_write(&l9733, cmd) ==
+                   ERR_L9733_FAIL_SPI_WRITE);
+
+        /* the outputs that are not staged keep the failed request */
+        dev.transfer = l9733_model_transfer;
+        l9733_device_stage(&l9733, L9733_COMMAND_OUTPUT, 0, 1);
+        TEST_CHECK(l9733_device_flush(&l9733) == 0);
+        TEST_CHECK(model.outputs == 0xF1);
+        TEST_CHECK(l9733.shadow[L9733_COMMAND_OUTPUT] == 0xF1);
+}
+
+static void test_device_flush_coalesces(void)
+{
+        struct l9733_model model;
+        struct spi_t dev;
+        struct l9733_device l9733;
+        const struct l9733_input_command all_off = {
+                L9733_COMMAND_KEYWORD, L9733_COMMAND_OUTPUT, 0x00
+        };
+        uint8_t n;
+
+        l9733_model_init(&model);
+        l9733_model_attach(&model, &dev);
+        l9733_device_init(&l9733, &dev);
+
+        TEST_CHECK(l9733_device_flush(&l9733) == 0);
+        TEST_CHECK(model.transactions == 0);
+        for (n = 0; n < L9733_NUMBER_OF_OUTPUTS; n++)
+                TEST_CHECK(l9733_device_stage(&l9733, L9733_COMMAND_OUTPUT,
+                                              n, n & 1) == 0);
+        l9733_device_stage(&l9733, L9733_COMMAND_PROTECTION, 2, 1);
+        TEST_CHECK(l9733_device_stage(&l9733, L9733_COMMAND_OUTPUT,
+                                      L9733_NUMBER_OF_OUTPUTS, 1) ==
+                   ERR_L9733_INVALID_COMMAND);
+        TEST_CHECK(l9733_device_flush(&l9733) == 0);
+        TEST_CHECK(model.transactions == 2);
+        TEST_CHECK(model.outputs == 0xAA && model.protection == 0x04);
+
+        /* a staged state equal to the shadow is not sent */
+        l9733_device_stage(&l9733, L9733_COMMAND_OUTPUT, 1, 1);
+        TEST_CHECK(l9733_device_flush(&l9733) == 0);
+        TEST_CHECK(model.transactions == 2);
+        TEST_CHECK(l9733.pending_mask[L9733_COMMAND_OUTPUT] == 0);
+
+        /* l9733_device_write drops the staged changes of its mode */
+        l9733_device_stage(&l9733, L9733_COMMAND_OUTPUT, 0, 1);
+        TEST_CHECK(l9733_device_write(&l9733, all_off) == 0);
+        TEST_CHECK(l9733_device_flush(&l9733) == 0);
+        TEST_CHECK(model.outputs == 0x00 && model.transactions == 3);
+}
+
+#define TEST_CHAIN_LENGTH (3)
+
+static void test_chain_write_spi(void)
+{
+        struct l9733_model chips[TEST_CHAIN_LENGTH];
+        struct l9733_model_chain chain = { chips, TEST_CHAIN_LENGTH };
+        struct spi_t dev;
+        const struct l9733_input_command cmds[TEST_CHAIN_LENGTH] = {
+                { L9733_COMMAND_KEYWORD, L9733_COMMAND_OUTPUT, 0x01 },
+                { 0, L9733_COMMAND_OUTPUT, 0x02 }, /* ignored by chip 1 */
+                { L9733_COMMAND_KEYWORD, L9733_COMMAND_PROTECTION, 0x03 }
+        };
+        int16_t faults[TEST_CHAIN_LENGTH];
+        size_t k;
+
+        for (k = 0; k < TEST_CHAIN_LENGTH; k++) {
+                l9733_model_init(&chips[k]);
+                l9733_model_set_fault(&chips[k], (uint8_t)k,
+                                      L9733_FAULT_OPEN_LOAD);
+        }
+        l9733_model_chain_attach(&chain, &dev);
+
+        TEST_CHECK(l9733_chain_write_spi(&dev, cmds, faults,
+                                         TEST_CHAIN_LENGTH) == 0);
+        TEST_CHECK(chips[0].outputs == 0x01 && chips[0].commands == 1);
+        TEST_CHECK(chips[1].outputs == 0x00 && chips[1].rejected == 1);
+        TEST_CHECK(chips[2].protection == 0x03 && chips[2].outputs == 0x00);
+        for (k = 0; k < TEST_CHAIN_LENGTH; k++) {
+                /* one transaction shifting a frame through every chip */
+                TEST_CHECK(chips[k].transactions == 1);
+                TEST_CHECK(chips[k].bytes ==
+                           TEST_CHAIN_LENGTH * L9733_FRAME_BYTES);
+                /* chip k reports a fault on output k */
+                TEST_CHECK(L9733_FAULT_STATUS_n(k, faults[k]) ==
+                           L9733_FAULT_OPEN_LOAD);
+                TEST_CHECK(faults[k] == L9733_FAULT_OPEN_LOAD << (2 * k));
+        }
+
+        TEST_CHECK(l9733_chain_write_spi(&dev, cmds, NULL,
+                                         L9733_MAX_CHAIN_LENGTH + 1) ==
+                   ERR_L9733_INVALID_COMMAND);
+        TEST_CHECK(chips[0].transactions == 1);
+}
+
+static void test_chain_read_fault_registers(void)
+{
+        struct l9733_model chips[TEST_CHAIN_LENGTH];
+        struct l9733_model_chain chain = { chips, TEST_CHAIN_LENGTH };
+        struct spi_t dev;
+        int16_t faults[TEST_CHAIN_LENGTH];
+        size_t k;
+
+        for (k = 0; k < TEST_CHAIN_LENGTH; k++) {
+                l9733_model_init(&chips[k]);
+                chips[k].outputs = 0xFF;
+        }
+        l9733_model_set_fault(&chips[0], 1, L9733_FAULT_SHORT_CIRCUIT);
+        l9733_model_set_fault(&chips[2], 6, L9733_FAULT_OVERCURRENT);
+        l9733_model_chain_attach(&chain, &dev);
+
+        TEST_CHECK(l9733_chain_read_fault_registers(&dev, faults,
+                                                    TEST_CHAIN_LENGTH) == 0);
+        TEST_CHECK(L9733_FAULT_STATUS_n(1, faults[0]) ==
+                   L9733_FAULT_SHORT_CIRCUIT);
+        TEST_CHECK(faults[1] == 0);
+        TEST_CHECK(L9733_FAULT_STATUS_n(6, faults[2]) ==
+                   L9733_FAULT_OVERCURRENT);
+        for (k = 0; k < TEST_CHAIN_LENGTH; k++)
+                TEST_CHECK(chips[k].outputs == 0xFF &&
+                           chips[k].commands == 0);
+
+        dev.transfer = test_transfer_fail;
+        TEST_CHECK(l9733_chain_read_fault_registers(&dev, faults,
+                                                    TEST_CHAIN_LENGTH) ==
+                   ERR_L9733_FAIL_SPI_READ);
+}
+
+static void test_chain_flush(void)
+{
+        struct l9733_model chips[TEST_CHAIN_LENGTH];
+        struct l9733_model_chain chain = { chips, TEST_CHAIN_LENGTH };
+        struct spi_t dev;
+        struct l9733_device l9733[TEST_CHAIN_LENGTH];
+        size_t k;
+
+        for (k = 0; k < TEST_CHAIN_LENGTH; k++) {
+                l9733_model_init(&chips[k]);
+                l9733_device_init(&l9733[k], &dev);
+        }
+        l9733_model_chain_attach(&chain, &dev);
+
+        /* chip 1 has no change and gets a NOP frame */
+        l9733_device_stage(&l9733[0], L9733_COMMAND_OUTPUT, 0, 1);
+        l9733_device_stage(&l9733[2], L9733_COMMAND_OUTPUT, 7, 1);
+        l9733_device_stage(&l9733[2], L9733_COMMAND_DIAGNOSTICS, 3, 1);
+        TEST_CHECK(l9733_chain_flush(l9733, TEST_CHAIN_LENGTH) == 0);
+        TEST_CHECK(chips[0].transactions == 2); /* output, diagnostics */
+        TEST_CHECK(chips[0].outputs == 0x01 && chips[0].commands == 1);
+        TEST_CHECK(chips[1].commands == 0 && chips[1].rejected == 2);
+        TEST_CHECK(chips[2].outputs == 0x80 && chips[2].latch == 0x08);
+        TEST_CHECK(chips[2].commands == 2);
+
+        /* nothing staged, or nothing changed: no transaction */
+        TEST_CHECK(l9733_chain_flush(l9733, TEST_CHAIN_LENGTH) == 0);
+        l9733_device_stage(&l9733[0], L9733_COMMAND_OUTPUT, 0, 1);
+        TEST_CHECK(l9733_chain_flush(l9733, TEST_CHAIN_LENGTH) == 0);
+        TEST_CHECK(chips[0].transactions == 2);
+
+        /* a failed transaction keeps the staged changes of every chip */
+        l9733_device_stage(&l9733[0], L9733_COMMAND_OUTPUT, 1, 1);
+        l9733_device_stage(&l9733[1], L9733_COMMAND_OUTPUT, 1, 1);
+        dev.transfer = test_transfer_fail;
+        TEST_CHECK(l9733_chain_flush(l9733, TEST_CHAIN_LENGTH) ==
+                   ERR_L9733_FAIL_SPI_WRITE);
+        TEST_CHECK(l9733[0].pending_mask[L9733_COMMAND_OUTPUT] == 0x02);
+        TEST_CHECK(l9733[1].pending_mask[L9733_COMMAND_OUTPUT] == 0x02);
+        dev.transfer = l9733_model_chain_transfer;
+        TEST_CHECK(l9733_chain_flush(l9733, TEST_CHAIN_LENGTH) == 0);
+        TEST_CHECK(chips[0].outputs == 0x03 && chips[1].outputs == 0x02);
+        TEST_CHECK(chips[2].outputs == 0x80 && chips[2].commands == 2);
+
+        TEST_CHECK(l9733_chain_flush(l9733, 0) == ERR_L9733_INVALID_COMMAND);
+}
+
+static void test_fault_poll(void)
+{
+        struct l9733_model model;
+        struct spi_t dev;
+        struct l9733_fault_poller poller;
+        struct l9733_fault_state state;
+        int n;
+
+        l9733_model_init(&model);
+        l9733_model_attach(&model, &dev);
+        l9733_fault_poller_init(&poller, &dev);
+        l9733_fault_snapshot(&poller, &state);
+        TEST_CHECK(state.generation == 0 && state.faulty == 0);
+
+        /* also the value of ERR_L9733_FAIL_SPI_READ as an int16_t: short
+         * circuit on output 0, open load on 1 and overcurrent on the rest */
+        model.faults = 0xFFF6;
+        TEST_CHECK(l9733_fault_poll(&poller) == 0);
+        TEST_CHECK(poller.errors == 0);
+        l9733_fault_snapshot(&poller, &state);
+        TEST_CHECK(state.generation == 1 && state.raw == 0xFFF6);
+        TEST_CHECK(state.output[0] == L9733_FAULT_SHORT_CIRCUIT);
+        TEST_CHECK(state.output[1] == L9733_FAULT_OPEN_LOAD);
+        for (n = 2; n < L9733_NUMBER_OF_OUTPUTS; n++)
+                TEST_CHECK(state.output[n] == L9733_FAULT_OVERCURRENT);
+        TEST_CHECK(state.faulty == 0xFF);
+
+        /* a failed poll keeps the last state published */
+        dev.transfer = test_transfer_fail;
+        TEST_CHECK(l9733_fault_poll(&poller) == ERR_L9733_FAIL_SPI_READ);
+        TEST_CHECK(poller.errors == 1);
+        l9733_fault_snapshot(&poller, &state);
+        TEST_CHECK(state.generation == 1 && state.raw == 0xFFF6);
+
+        dev.transfer = l9733_model_transfer;
+        l9733_model_init(&model);
+        l9733_model_set_fault(&model, 5, L9733_FAULT_OPEN_LOAD);
+        TEST_CHECK(l9733_fault_poll(&poller) == 0);
+        l9733_fault_snapshot(&poller, &state);
+        TEST_CHECK(state.generation == 2 && state.faulty == (1u << 5));
+        TEST_CHECK(state.output[5] == L9733_FAULT_OPEN_LOAD);
+        TEST_CHECK(state.output[0] == L9733_FAULT_NO_FAULT);
+}
+
+/* a controller whose transfers are interrupted by a fault poll, like a timer
+ * interrupt firing during the control loop's CS window */
+struct test_preempted_bus {
+        struct l9733_model model;
+        struct l9733_fault_poller *poller;
+        int poll_result;
+};
+
+static int test_transfer_preempted(void *ctx, const uint8_t *tx, uint8_t *rx,
+                                   size_t len)
+{
+        struct test_preempted_bus *bus = ctx;
+
+        bus->poll_result = l9733_fault_poll(bus->poller);
+        return l9733_model_transfer(&bus->model, tx, rx, len);
+}
+
+static void test_fault_poll_preempting_transfer(void)
+{
+        struct test_preempted_bus bus;
+        struct spi_t dev;
+        struct l9733_fault_poller poller;
+        struct l9733_fault_state state;
+        const struct l9733_input_command cmd = {
+                L9733_COMMAND_KEYWORD, L9733_COMMAND_OUTPUT, 0x3C
+        };
+
+        l9733_model_init(&bus.model);
+        l9733_model_attach(&bus.model, &dev);
+        l9733_model_set_fault(&bus.model, 2, L9733_FAULT_OPEN_LOAD);
+        bus.poller = &poller;
+        l9733_fault_poller_init(&poller, &dev);
+
+        /* the poll is skipped, the interrupted write goes through */
+        dev.transfer = test_transfer_preempted;
+        dev.ctx = &bus;
+        TEST_CHECK(l9733_write_spi(&dev, cmd) == 0);
+        TEST_CHECK(bus.poll_result == ERR_L9733_BUS_BUSY);
+        TEST_CHECK(poller.errors == 1 && poller.sequence == 0);
+        TEST_CHECK(bus.model.transactions == 1 && bus.model.outputs == 0x3C);
+        TEST_CHECK(dev.busy == 0);
+
+        /* and the next poll outside a transfer reads the chip */
+        l9733_model_attach(&bus.model, &dev);
+        TEST_CHECK(l9733_fault_poll(&poller) == 0);
+        l9733_fault_snapshot(&poller, &state);
+        TEST_CHECK(state.generation == 1 && state.faulty == (1u << 2));
+
+        /* a write preempting the poller is refused the same way */
+        dev.busy = 1;
+        TEST_CHECK(l9733_write_spi(&dev, cmd) == ERR_L9733_BUS_BUSY);
+        TEST_CHECK(bus.model.transactions == 2);
+}
+
+static void test_fault_poll_sequence_wrap(void)
+{
+        struct l9733_fault_poller poller;
+        struct l9733_fault_state state;
+        const uint32_t generations[] = { 0x7FFFFFFF, 0x80000000, 1, 2 };
+        size_t i;
+
+        l9733_fault_poller_init(&poller, NULL);
+        poller.sequence = 0xFFFFFFFC;
+        for (i = 0; i < sizeof(generations) / sizeof(generations[0]); i++) {
+                l9733_fault_poll_complete(&poller, (uint16_t)(i + 1));
+                l9733_fault_snapshot(&poller, &state);
+                TEST_CHECK(state.generation == generations[i]);
+                TEST_CHECK(state.raw == i + 1);
+        }
+}
+
+static void test_fault_snapshot_retry(void)
+{
+        const uint32_t g = 7;
+
+        /* copied while generation g was published */
+        TEST_CHECK(!L9733_FAULT_SNAPSHOT_TORN(2 * g, 2 * g));
+        TEST_CHECK(!L9733_FAULT_SNAPSHOT_TORN(2 * g, 2 * g + 1));
+        TEST_CHECK(!L9733_FAULT_SNAPSHOT_TORN(2 * g, 2 * g + 2));
+        TEST_CHECK(L9733_FAULT_SNAPSHOT_TORN(2 * g, 2 * g + 3));
+        TEST_CHECK(L9733_FAULT_SNAPSHOT_TORN(2 * g, 2 * g + 8));
+        /* copied generation g - 1 while g was written */
+        TEST_CHECK(!L9733_FAULT_SNAPSHOT_TORN(2 * g - 1, 2 * g - 1));
+        TEST_CHECK(!L9733_FAULT_SNAPSHOT_TORN(2 * g - 1, 2 * g));
+        TEST_CHECK(L9733_FAULT_SNAPSHOT_TORN(2 * g - 1, 2 * g + 1));
+        /* across the wrap of the sequence */
+        TEST_CHECK(!L9733_FAULT_SNAPSHOT_TORN(0xFFFFFFFEu, 0xFFFFFFFFu));
+        TEST_CHECK(!L9733_FAULT_SNAPSHOT_TORN(0xFFFFFFFEu, 0));
+        TEST_CHECK(L9733_FAULT_SNAPSHOT_TORN(0xFFFFFFFEu, 1));
+        TEST_CHECK(!L9733_FAULT_SNAPSHOT_TORN(0xFFFFFFFFu, 0));
+        TEST_CHECK(L9733_FAULT_SNAPSHOT_TORN(0xFFFFFFFFu, 1));
+}
+
+int main(void)
+{
+        test_encode_frame();
+        test_constant_frames();
+        test_write_frame();
+        test_write_spi();
+        test_model_echoes_previous_frame();
+        test_read_fault_register();
+        test_spi_errors();
+        test_device_skips_unchanged_writes();
+        test_device_rejects_bad_keyword();
+        test_device_write_error_invalidates_shadow();
+        test_device_flush_after_failed_write();
+        test_device_flush_coalesces();
+        test_chain_write_spi();
+        test_chain_read_fault_registers();
+        test_chain_flush();
+        test_fault_poll();
+        test_fault_poll_preempting_transfer();
+        test_fault_poll_sequence_wrap();
+        test_fault_snapshot_retry();
+
+        if (test_failures) {
+                printf("%d checks failed\n", test_failures);
+                return EXIT_FAILURE;
+        }
+        printf("all tests passed\n");
+        return EXIT_SUCCESS;
+}
@@ -0,0 +1,365 @@
+#include "spi_l9733.h"
+
+#include <string.h>
+
+/* orders the fault state copies against the sequence counter */
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && \
+        !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+#define L9733_FENCE() atomic_thread_fence(memory_order_seq_cst)
+#elif defined(__GNUC__)
+#define L9733_FENCE() __sync_synchronize()
+#else
+/* single core MC, the poller runs in an interrupt: the volatile accesses
+ * of the sequence counter are not reordered */
+#define L9733_FENCE() do { } while (0)
+#endif
+
+/* claims the controller for one CS window, fails while it is claimed */
+#if defined(__GNUC__)
+#define L9733_BUS_CLAIM(dev) (__sync_lock_test_and_set(&(dev)->busy, 1) == 0)
+#define L9733_BUS_RELEASE(dev) __sync_lock_release(&(dev)->busy)
+#else
+/* single core MC, an interrupt completes before the code it preempted
+ * continues: the flag cannot change between its test and set */
+#define L9733_BUS_CLAIM(dev) ((dev)->busy ? 0 : ((dev)->busy = 1))
+#define L9733_BUS_RELEASE(dev) ((dev)->busy = 0)
+#endif
+
+struct spi_t l9733_spi_driver;
+
+/* mode nibble sent on the wire for each l9733_command_mode */
+static const uint8_t l9733_mode_nibble[] = {
+        [L9733_COMMAND_OUTPUT] = L9733_COMMAND_MODE_OUTPUT,
+        [L9733_COMMAND_DIAGNOSTICS] = L9733_COMMAND_MODE_DIAGNOSTICS,
+        [L9733_COMMAND_PROTECTION] = L9733_COMMAND_MODE_PROTECTION,
+};
+
+/* l9733_chain_transfer shift one frame to every chip of a daisy chain in a
+ * single CS window, and read back every fault register.
+ * @frames frame for each chip, chip 0 is connected to the MC's DI
+ * @faults fault register of each chip, may be NULL
+ * @return error status
+ */
+static int l9733_chain_transfer(struct spi_t *dev, size_t n,
+                                const uint16_t *frames, uint16_t *faults)
+{
+        uint8_t tx[L9733_MAX_CHAIN_LENGTH * L9733_FRAME_BYTES];
+        uint8_t rx[L9733_MAX_CHAIN_LENGTH * L9733_FRAME_BYTES];
+        size_t i;
+        int err;
+
+        if (n == 0 || n > L9733_MAX_CHAIN_LENGTH)
+                return ERR_L9733_INVALID_COMMAND;
+        if (!dev || !dev->transfer)
+                return ERR_L9733_FAIL_SPI_WRITE;
+
+        /* the first frame on the wire travels to the far end of the chain,
+         * whose fault register is also the first to come back */
+        for (i = 0; i < n; i++) {
+                tx[L9733_FRAME_BYTES * i] = (uint8_t)(frames[n - 1 - i] >> 8);
+                tx[L9733_FRAME_BYTES * i + 1] = (uint8_t)frames[n - 1 - i];
+        }
+        if (!L9733_BUS_CLAIM(dev))
+                return ERR_L9733_BUS_BUSY;
+        err = dev->transfer(dev->ctx, tx, rx, n * L9733_FRAME_BYTES);
+        L9733_BUS_RELEASE(dev);
+        if (err != 0)
+                return ERR_L9733_FAIL_SPI_WRITE;
+        for (i = 0; faults && i < n; i++)
+                faults[n - 1 - i] =
+                        (uint16_t)((rx[L9733_FRAME_BYTES * i] << 8) |
+                                   rx[L9733_FRAME_BYTES * i + 1]);
+        return 0;
+}
+
+/* l9733_transfer_frame shift one frame out on DI and the fault register in
+ * from DO, in a single CS window.
+ * @return the fault register, or a negative error status
+ */
+static int32_t l9733_transfer_frame(struct spi_t *dev, uint16_t frame)
+{
+        uint16_t faults;
+        const int err = l9733_chain_transfer(dev, 1, &frame, &faults);
+
+        return err ? err : faults;
+}
+
+int32_t l9733_encode_frame(struct l9733_input_command cmd)
+{
+        if ((unsigned)cmd.mode >=
+            sizeof(l9733_mode_nibble) / sizeof(l9733_mode_nibble[0]))
+                return ERR_L9733_INVALID_COMMAND;
+        return ((int32_t)(cmd.keyword & 0xf) << 12) |
+               ((int32_t)l9733_mode_nibble[cmd.mode] << 8) |
+               cmd.output_mode_mask;
+}
+
+int l9733_write_frame(struct spi_t *dev, uint16_t frame)
+{
+        const int32_t faults = l9733_transfer_frame(dev, frame);
+
+        return faults < 0 ? (int)faults : 0;
+}
+
+int l9733_initialize_spi(struct spi_t *dev)
+{
+        /* the platform configures the controller before filling in dev,
+         * only check that it can be used */
+        if (!dev || !dev->transfer)
+                return ERR_L9733_FAIL_SPI_WRITE;
+        dev->busy = 0;
+        return 0;
+}
+
+int l9733_write_spi(struct spi_t *dev, struct l9733_input_command cmd)
+{
+        const int32_t frame = l9733_encode_frame(cmd);
+
+        if (frame < 0)
+                return (int)frame;
+        return l9733_write_frame(dev, (uint16_t)frame);
+}
+
+int16_t l9733_read_fault_register(struct spi_t *dev)
+{
+        const int32_t faults = l9733_transfer_frame(dev, L9733_FRAME_NOP);
+
+        if (faults < 0)
+                return ERR_L9733_FAIL_SPI_READ;
+        return (int16_t)faults;
+}
+
+void l9733_device_init(struct l9733_device *l9733, struct spi_t *dev)
+{
+        l9733->dev = dev;
+        l9733_device_invalidate(l9733);
+}
+
+void l9733_device_invalidate(struct l9733_device *l9733)
+{
+        int mode;
+
+        l9733->shadow_valid = 0;
+        for (mode = 0; mode < L9733_NUMBER_OF_COMMAND_MODES; mode++) {
+                l9733->shadow[mode] = 0;
+                l9733->pending_mask[mode] = 0;
+                l9733->pending_state[mode] = 0;
+        }
+}
+
+int l9733_device_write(struct l9733_device *l9733,
+                       struct l9733_input_command cmd)
+{
+        uint8_t mode_bit;
+        int err;
+
+        /* the chip ignores other key-words, the shadow would not match */
+        if (cmd.keyword != L9733_COMMAND_KEYWORD ||
+            (unsigned)cmd.mode >= L9733_NUMBER_OF_COMMAND_MODES)
+                return ERR_L9733_INVALID_COMMAND;
+        mode_bit = (uint8_t)(1u << cmd.mode);
+        l9733->pending_mask[cmd.mode] = 0;
+        if ((l9733->shadow_valid & mode_bit) &&
+            l9733->shadow[cmd.mode] == cmd.output_mode_mask)
+                return 0;
+
+        /* kept even if the write fails, so the next flush builds on the
+         * latest request and not the mask before it */
+        l9733->shadow[cmd.mode] = cmd.output_mode_mask;
+        err = l9733_write_spi(l9733->dev, cmd);
+        if (err) {
+                /* unknown whether the chip took the frame */
+                l9733->shadow_valid &= (uint8_t)~mode_bit;
+                return err;
+        }
+        l9733->shadow_valid |= mode_bit;
+        return 0;
+}
+
+int l9733_device_stage(struct l9733_device *l9733,
+                       enum l9733_command_mode mode, uint8_t output_n,
+                       uint8_t state)
+{
+        uint8_t output_bit;
+
+        if ((unsigned)mode >= L9733_NUMBER_OF_COMMAND_MODES ||
+            output_n >= L9733_NUMBER_OF_OUTPUTS)
+                return ERR_L9733_INVALID_COMMAND;
+        output_bit = (uint8_t)(1u << output_n);
+        l9733->pending_mask[mode] |= output_bit;
+        if (state)
+                l9733->pending_state[mode] |= output_bit;
+        else
+                l9733->pending_state[mode] &= (uint8_t)~output_bit;
+        return 0;
+}
+
+int l9733_device_flush(struct l9733_device *l9733)
+{
+        return l9733_chain_flush(l9733, 1);
+}
+
+int l9733_chain_write_spi(struct spi_t *dev,
+                          const struct l9733_input_command *cmds,
+                          int16_t *faults, size_t n)
+{
+        uint16_t frames[L9733_MAX_CHAIN_LENGTH];
+        size_t i;
+
+        if (n > L9733_MAX_CHAIN_LENGTH)
+                return ERR_L9733_INVALID_COMMAND;
+        for (i = 0; i < n; i++) {
+                const int32_t frame = l9733_encode_frame(cmds[i]);
+
+                if (frame < 0)
+                        return (int)frame;
+                frames[i] = (uint16_t)frame;
+        }
+        return l9733_chain_transfer(dev, n, frames, (uint16_t *)faults);
+}
+
+int l9733_chain_read_fault_registers(struct spi_t *dev, int16_t *faults,
+                                     size_t n)
+{
+        uint16_t frames[L9733_MAX_CHAIN_LENGTH];
+        size_t i;
+
+        if (n > L9733_MAX_CHAIN_LENGTH)
+                return ERR_L9733_INVALID_COMMAND;
+        for (i = 0; i < n; i++)
+                frames[i] = L9733_FRAME_NOP;
+        if (l9733_chain_transfer(dev, n, frames, (uint16_t *)faults) != 0)
+                return ERR_L9733_FAIL_SPI_READ;
+        return 0;
+}
+
+int l9733_chain_flush(struct l9733_device *chain, size_t n)
+{
+        uint16_t frames[L9733_MAX_CHAIN_LENGTH];
+        uint8_t masks[L9733_MAX_CHAIN_LENGTH];
+        int mode, err, ret = 0;
+        size_t i;
+
+        if (n == 0 || n > L9733_MAX_CHAIN_LENGTH)
+                return ERR_L9733_INVALID_COMMAND;
+
+        for (mode = 0; mode < L9733_NUMBER_OF_COMMAND_MODES; mode++) {
+                const uint8_t mode_bit = (uint8_t)(1u << mode);
+                int send = 0;
+
+                for (i = 0; i < n; i++) {
+                        struct l9733_device *l9733 = &chain[i];
+                        const uint8_t pending = l9733->pending_mask[mode];
+                        const struct l9733_input_command cmd = {
+                                L9733_COMMAND_KEYWORD,
+                                (enum l9733_command_mode)mode,
+                                /* outputs without a staged change keep the
+                                 * shadow state, which is the reset state
+                                 * (all 0) before the first write */
+                                (uint8_t)((l9733->shadow[mode] & ~pending) |
+                                          (l9733->pending_state[mode] &
+                                           pending))
+                        };
+
+                        frames[i] = L9733_FRAME_NOP;
+                        if (!pending)
+                                continue;
+                        masks[i] = cmd.output_mode_mask;
+                        if ((l9733->shadow_valid & mode_bit) &&
+                            l9733->shadow[mode] == masks[i]) {
+                                l9733->pending_mask[mode] = 0;
+                                continue;
+                        }
+                        frames[i] = (uint16_t)l9733_encode_frame(cmd);
+                        send = 1;
+                }
+                if (!send)
+                        continue;
+
+                /* chips without a change get a NOP frame */
+                err = l9733_chain_transfer(chain[0].dev, n, frames, NULL);
+                for (i = 0; i < n; i++) {
+                        struct l9733_device *l9733 = &chain[i];
+
+                        if (frames[i] == L9733_FRAME_NOP)
+                                continue;
+                        if (err) {
+                                /* unknown whether the chip took the frame,
+                                 * the staged changes are kept */
+                                l9733->shadow_valid &= (uint8_t)~mode_bit;
+                                continue;
+                        }
+                        l9733->shadow[mode] = masks[i];
+                        l9733->shadow_valid |= mode_bit;
+                        l9733->pending_mask[mode] = 0;
+                }
+                if (err)
+                        ret = err;
+        }
+        return ret;
+}
+
+void l9733_fault_poller_init(struct l9733_fault_poller *poller,
+                             struct spi_t *dev)
+{
+        memset(poller->state, 0, sizeof(poller->state));
+        poller->dev = dev;
+        poller->sequence = 0;
+        poller->errors = 0;
+}
+
+int l9733_fault_poll(struct l9733_fault_poller *poller)
+{
+        /* not l9733_read_fault_register: its error value is also a valid
+         * fault register */
+        const int32_t faults = l9733_transfer_frame(poller->dev,
+                                                    L9733_FRAME_NOP);
+
+        if (faults < 0) {
+                poller->errors++;
+                return faults == ERR_L9733_BUS_BUSY ? ERR_L9733_BUS_BUSY
+                                                    : ERR_L9733_FAIL_SPI_READ;
+        }
+        l9733_fault_poll_complete(poller, (uint16_t)faults);
+        return 0;
+}
+
+void l9733_fault_poll_complete(struct l9733_fault_poller *poller,
+                               uint16_t faults)
+{
+        const uint32_t generation = (poller->sequence >> 1) + 1;
+        struct l9733_fault_state *state = &poller->state[generation & 1];
+        int n;
+
+        /* odd: writing the buffer that is not published */
+        poller->sequence = 2 * generation - 1;
+        L9733_FENCE();
+
+        state->raw = faults;
+        state->faulty = 0;
+        for (n = 0; n < L9733_NUMBER_OF_OUTPUTS; n++) {
+                state->output[n] = L9733_FAULT_STATUS_n(n, faults);
+                if (state->output[n] != L9733_FAULT_NO_FAULT)
+                        state->faulty |= (uint8_t)(1u << n);
+        }
+        state->generation = generation;
+
+        L9733_FENCE();
+        poller->sequence = 2 * generation;
+}
+
+void l9733_fault_snapshot(const struct l9733_fault_poller *poller,
+                          struct l9733_fault_state *state)
+{
+        uint32_t before, after;
+
+        do {
+                before = poller->sequence;
+                L9733_FENCE();
+                memcpy(state, &poller->state[(before >> 1) & 1],
+                       sizeof(*state));
+                L9733_FENCE();
+                after = poller->sequence;
+        } while (L9733_FAULT_SNAPSHOT_TORN(before, after));
+}
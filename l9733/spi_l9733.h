@@ -1,7 +1,11 @@
+#ifndef SPI_L9733_H
+#define SPI_L9733_H
+
+#include <stddef.h>
 #include <stdint.h>
-/* include spi.h
- * spi_t type represents SPI controller
- * assume there are read/write operations available
+/* spi_t type represents SPI controller
+ * the read/write operation is supplied by the platform as a transfer hook,
+ * \see l9733_model.h for a software model of the L9733 on the other end
  */
 
 /* L9733 driver configuration overview
@@ -33,11 +37,33 @@
  * Chip select (CS):
  */
 
+/* spi_transfer_fn full duplex transfer on the SPI bus
+ * || @ctx: spi_t.ctx of the controller
+ * || @tx: len bytes shifted out on DI, 16 bit frames are sent high byte
+ *     first and each byte LSB first (the controller is configured for it)
+ * || @rx: len bytes shifted in from DO, same order as tx
+ * || CS is held at logic 0 for the whole transfer
+ * @return error status
+ */
+typedef int (*spi_transfer_fn)(void *ctx, const uint8_t *tx, uint8_t *rx,
+                               size_t len);
+
 /* spi_t The MC's SPI controller
- * || @dev: The device for communicating with controller
+ * || @transfer: The transfer operation of the controller
+ * || @ctx: The device for communicating with controller
+ * || @busy: set by the driver while a transfer runs, so a transfer started
+ *     from an interrupt (e.g. l9733_fault_poll) that preempts another one
+ *     fails with ERR_L9733_BUS_BUSY instead of mixing the two CS windows.
+ *     0 when the controller is set up.
  */
-static struct spi_t {
-} l9733_spi_driver;
+struct spi_t {
+        spi_transfer_fn transfer;
+        void *ctx;
+        volatile int busy;
+};
+
+/* the controller wired to the L9733, set up by the platform */
+extern struct spi_t l9733_spi_driver;
 
 /* l9733_output_fault the fault register consists of an array of 2 bits
  * used to indicate the faults of each outputs.
@@ -60,6 +86,16 @@ enum l9733_command_mode {
         L9733_COMMAND_PROTECTION
 };
 
+/* Every command frame must start with this key-word, otherwise the L9733
+ * ignores the frame. L9733_FRAME_NOP (invalid key-word) can therefore be
+ * sent to shift out the fault register without changing any state.
+ */
+#define L9733_COMMAND_KEYWORD (0b1010)
+#define L9733_FRAME_NOP (0x0000)
+
+/* Length of a frame (and the fault register) on the wire */
+#define L9733_FRAME_BYTES (2)
+
 /* for implementation: send this down SPI wire for selected l9733_command_mode */
 #define L9733_COMMAND_MODE_OUTPUT (0b1100)
 #define L9733_COMMAND_MODE_DIAGNOSTICS (0b0011)
@@ -67,6 +103,9 @@ enum l9733_command_mode {
 
 /* Errors */
 #define ERR_L9733_FAIL_SPI_READ (-10)
+#define ERR_L9733_FAIL_SPI_WRITE (-11)
+#define ERR_L9733_INVALID_COMMAND (-12)
+#define ERR_L9733_BUS_BUSY (-13)
 
 /* Total number of outputs available in L9733 */
 #define L9733_NUMBER_OF_OUTPUTS (8)
@@ -82,13 +121,63 @@ enum l9733_command_mode {
 /* Set a new state for an output N
  * || shifts the state for output N to the correct flag position in the mask
  */
-#define L9733_OUTPUT_STATE_n(n, s) (s << n)
+#define L9733_OUTPUT_STATE_n(n, s) ((s) << (n))
 
 /* Decode a fault state for a particular output from the fault register.
  * || extracts the fault for output N
  */
 #define L9733_FAULT_STATUS_n(n, faults) \
-        ((enum l9733_output_fault)((faults >> (2*n)) & 0x3))
+        ((enum l9733_output_fault)(((uint16_t)(faults) >> (2 * (n))) & 0x3))
+
+/* ==== CONSTANT FRAMES ====
+ * The macros below are integer constant expressions, so commands known at
+ * build time are encoded by the compiler, e.g.
+ *     static const uint16_t all_off = L9733_FRAME_OUTPUT(0);
+ * and the hot path only sends the stored word with l9733_write_frame.
+ */
+
+/* Evaluates to 0, or fails to compile if cond is true or not a constant */
+#define L9733_BUILD_BUG_ON_ZERO(cond) \
+        (0 * (int)sizeof(struct { int l9733_build_bug : 1 - 2 * !!(cond); }))
+
+/* L9733_OUTPUT_STATE_n for a constant output N and state S: the build fails
+ * unless N is below L9733_NUMBER_OF_OUTPUTS and S is 0 or 1
+ */
+#define L9733_OUTPUT_STATE(n, s) \
+        (L9733_OUTPUT_STATE_n(n, s) + \
+         L9733_BUILD_BUG_ON_ZERO((n) < 0 || (n) >= L9733_NUMBER_OF_OUTPUTS) + \
+         L9733_BUILD_BUG_ON_ZERO((s) < 0 || (s) > 1))
+
+/* The 16 bit frame: [keyword] [mode] [OUTn] = [b15-b12] [b11-b8] [b7-b0]
+ * @mode_nibble: one of L9733_COMMAND_MODE_*, otherwise the build fails
+ * @mask: output_mode_mask, \see L9733_OUTPUT_STATE. The build fails if it
+ *     does not fit in 8 bits, i.e. names an output that does not exist
+ */
+#define L9733_FRAME(mode_nibble, mask) \
+        ((uint16_t)((L9733_COMMAND_KEYWORD << 12) | ((mode_nibble) << 8) | \
+                    (mask) | \
+                    L9733_BUILD_BUG_ON_ZERO( \
+                            (mode_nibble) != L9733_COMMAND_MODE_OUTPUT && \
+                            (mode_nibble) != L9733_COMMAND_MODE_DIAGNOSTICS && \
+                            (mode_nibble) != L9733_COMMAND_MODE_PROTECTION) | \
+                    L9733_BUILD_BUG_ON_ZERO((mask) < 0 || (mask) > 0xff)))
+#define L9733_FRAME_OUTPUT(mask) L9733_FRAME(L9733_COMMAND_MODE_OUTPUT, mask)
+#define L9733_FRAME_DIAGNOSTICS(mask) \
+        L9733_FRAME(L9733_COMMAND_MODE_DIAGNOSTICS, mask)
+#define L9733_FRAME_PROTECTION(mask) \
+        L9733_FRAME(L9733_COMMAND_MODE_PROTECTION, mask)
+
+/* Each byte of a frame goes on the wire LSB first. For a controller that
+ * can only shift MSB first, send L9733_FRAME_MSB_FIRST(frame) instead: the
+ * bits of each byte are reversed, the byte order stays.
+ */
+#define L9733_BIT_REVERSE8(b) \
+        ((((b) & 0x01) << 7) | (((b) & 0x02) << 5) | (((b) & 0x04) << 3) | \
+         (((b) & 0x08) << 1) | (((b) & 0x10) >> 1) | (((b) & 0x20) >> 3) | \
+         (((b) & 0x40) >> 5) | (((b) & 0x80) >> 7))
+#define L9733_FRAME_MSB_FIRST(frame) \
+        ((uint16_t)((L9733_BIT_REVERSE8(((frame) >> 8) & 0xff) << 8) | \
+                    L9733_BIT_REVERSE8((frame) & 0xff)))
 
 /* Set to whichever GPIO Pins are connected from L9733 to this MC */
 #define GPIO_PIN_1 (assert("undefined"))
@@ -111,7 +200,8 @@ enum l9733_command_mode {
  *      * output: command each output OFF (0)/ON (1)
  *      * diagnostics: set No Latch Mode (0)/Latch Mode (1) for each output
  *      * protection: switch OFF (0) or set linear overcurrent protection (1)
- *     \see L9733_OUTPUT_STATE_n can use this to set output_mode_mask, for example
+ *     \see L9733_OUTPUT_STATE_n can use this to set output_mode_mask, or
+ *     L9733_OUTPUT_STATE to check a constant N at build time, for example
  *     (L9733_OUTPUT_STATE_n(0, L9733_COMMAND_SET_PROTECTION_ON)
  *     | L9733_OUTPUT_STATE_n(1, L9733_COMMAND_SET_PROTECTION_OFF)
  *     ...)
@@ -133,6 +223,12 @@ int l9733_initialize_spi(struct spi_t *dev);
  */
 int l9733_write_spi(struct spi_t *dev, struct l9733_input_command cmd);
 
+/* l9733_write_frame send a frame that is already encoded, e.g. by
+ *     L9733_FRAME_OUTPUT, without any checks.
+ * @return error status
+ */
+int l9733_write_frame(struct spi_t *dev, uint16_t frame);
+
 /* l9733_write_pin use discrete inputs on the l9733 to update an output
  * @output_n select one of these outputs: 
  *     * Output 6 (L9733_OUTPUT_6_PIN)
@@ -162,3 +258,182 @@ int16_t l9733_read_fault_register(struct spi_t *dev);
 int l9733_read_fault_register(struct spi_t *dev,
                               enum l9733_output_fault states[L9733_NUMBER_OF_OUTPUTS]);
 */
+
+/* l9733_encode_frame build the 16 bit frame sent on DI for a command.
+ * @cmd The command to encode. \see l9733_input_command
+ * @return the frame, or ERR_L9733_INVALID_COMMAND for an unknown mode
+ */
+int32_t l9733_encode_frame(struct l9733_input_command cmd);
+
+/* Number of l9733_command_mode, i.e. of writable registers */
+#define L9733_NUMBER_OF_COMMAND_MODES (3)
+
+/* l9733_device driver state of one L9733, caching what was written to it
+ * @dev: the MC's SPI controller used to communicate with l9733
+ * @shadow: last mask written for each l9733_command_mode, or attempted if
+ *     the write failed
+ * @shadow_valid: bit m set if shadow[m] matches the chip
+ * @pending_mask: outputs with a staged change, for each l9733_command_mode
+ * @pending_state: the staged states, only bits in pending_mask are used
+ */
+struct l9733_device {
+        struct spi_t *dev;
+        uint8_t shadow[L9733_NUMBER_OF_COMMAND_MODES];
+        uint8_t shadow_valid;
+        uint8_t pending_mask[L9733_NUMBER_OF_COMMAND_MODES];
+        uint8_t pending_state[L9733_NUMBER_OF_COMMAND_MODES];
+};
+
+/* l9733_device_init start without any knowledge of the chip state, so the
+ *     first write of each mode is always sent.
+ * @dev the MC's SPI controller used to communicate with l9733
+ */
+void l9733_device_init(struct l9733_device *l9733, struct spi_t *dev);
+
+/* l9733_device_invalidate forget the shadow registers, e.g. after
+ *     l9733_reset or an SPI error, and drop staged changes.
+ */
+void l9733_device_invalidate(struct l9733_device *l9733);
+
+/* l9733_device_write like l9733_write_spi, but the frame is only sent if
+ *     cmd.output_mode_mask differs from the shadow register of cmd.mode.
+ *     Changes staged for cmd.mode are dropped.
+ * @return error status, ERR_L9733_INVALID_COMMAND if cmd.keyword is not
+ *     L9733_COMMAND_KEYWORD
+ */
+int l9733_device_write(struct l9733_device *l9733,
+                       struct l9733_input_command cmd);
+
+/* l9733_device_stage record a new state for output N, nothing is sent
+ *     until l9733_device_flush, so changes to several outputs of the same
+ *     mode end up in one frame.
+ * @mode the register to change. \see l9733_command_mode
+ * @output_n the output (0 based)
+ * @state e.g. L9733_COMMAND_SET_OUTPUT_ON
+ * @return error status
+ */
+int l9733_device_stage(struct l9733_device *l9733,
+                       enum l9733_command_mode mode, uint8_t output_n,
+                       uint8_t state);
+
+/* l9733_device_flush send one frame per mode with staged changes, skipping
+ *     modes whose register would not change.
+ * @return error status, the staged changes of a failed mode are kept
+ */
+int l9733_device_flush(struct l9733_device *l9733);
+
+/* ==== DAISY CHAIN ====
+ * Several L9733 can share one CS: the DO of each chip is connected to the DI
+ * of the next, chip 0 receives the MC's DI and the last chip drives the MC's
+ * DO. One CS window of n frames then shifts one frame into every chip, while
+ * their fault registers are shifted out. Chips that shall keep their state
+ * are sent L9733_FRAME_NOP.
+ */
+
+/* Longest daisy chain supported, bounds the transfer buffers */
+#define L9733_MAX_CHAIN_LENGTH (16)
+
+/* l9733_chain_write_spi send one command to each chip of a daisy chain, in
+ *     a single transaction.
+ * @dev the MC's SPI controller of the chain
+ * @cmds command for each chip, chip 0 first. Use a keyword other than
+ *     L9733_COMMAND_KEYWORD for chips that shall ignore the transaction.
+ * @faults if not NULL, receives the fault register of each chip
+ * @n number of chips in the chain
+ * @return error status
+ */
+int l9733_chain_write_spi(struct spi_t *dev,
+                          const struct l9733_input_command *cmds,
+                          int16_t *faults, size_t n);
+
+/* l9733_chain_read_fault_registers read the fault register of every chip of
+ *     a daisy chain in a single transaction, without changing their state.
+ * @faults receives the fault register of each chip, chip 0 first
+ * @return ERR_L9733_FAIL_SPI_READ if error occured, otherwise 0
+ */
+int l9733_chain_read_fault_registers(struct spi_t *dev, int16_t *faults,
+                                     size_t n);
+
+/* l9733_chain_flush l9733_device_flush for every chip of a daisy chain,
+ *     with one transaction per mode for the whole chain.
+ * @chain the chips, chip 0 first, all using the SPI controller of chip 0
+ * @return error status
+ */
+int l9733_chain_flush(struct l9733_device *chain, size_t n);
+
+/* ==== FAULT POLLING ====
+ * Instead of blocking on l9733_read_fault_register, the fault register can be
+ * polled in the background, from a timer interrupt or the completion of a
+ * DMA transfer. Each poll is decoded once into a l9733_fault_state, which the
+ * control loop copies out with l9733_fault_snapshot without touching the bus.
+ * The poll shares the SPI controller with the control loop: a poll that
+ * preempts another transfer on it is skipped and counted in
+ * l9733_fault_poller.errors, \see spi_t.busy. A controller with its own
+ * locking can instead run the poll only between the control loop's transfers.
+ * The poller reads a single chip. On a daisy chain its one NOP frame would
+ * shift chip 0's fault register into chip 1, to be executed as a command;
+ * use l9733_chain_read_fault_registers there.
+ */
+
+/* l9733_fault_state the decoded fault register
+ * @raw: the fault register as read, \see L9733_FAULT_STATUS_n
+ * @output: the fault of each output
+ * @faulty: bit n set if output n has any fault
+ * @generation: number of the poll that produced this state, 0 before the
+ *     first poll
+ */
+struct l9733_fault_state {
+        uint16_t raw;
+        enum l9733_output_fault output[L9733_NUMBER_OF_OUTPUTS];
+        uint8_t faulty;
+        uint32_t generation;
+};
+
+/* l9733_fault_poller double buffer of the decoded fault register.
+ * There must be a single poller, snapshots may be taken concurrently.
+ * @dev: the MC's SPI controller used to communicate with l9733
+ * @state: the published state is state[generation & 1], the poller decodes
+ *     into the other one
+ * @sequence: 2 * generation, +1 while the poller writes a state
+ * @errors: number of failed polls, the last state stays published
+ */
+struct l9733_fault_poller {
+        struct spi_t *dev;
+        struct l9733_fault_state state[2];
+        volatile uint32_t sequence;
+        volatile uint32_t errors;
+};
+
+/* L9733_FAULT_SNAPSHOT_TORN the poller may have overwritten a state copied
+ *     while its sequence went from before to after. The copied buffer is
+ *     only written again once the poller starts the generation after next,
+ *     at sequence 2 * g + 3; the difference is taken modulo 2^32, so this
+ *     holds across the wrap of the sequence.
+ */
+#define L9733_FAULT_SNAPSHOT_TORN(before, after) \
+        ((uint32_t)((uint32_t)(after) - ((uint32_t)(before) & ~1u)) > 2)
+
+/* l9733_fault_poller_init publish a state without faults, generation 0 */
+void l9733_fault_poller_init(struct l9733_fault_poller *poller,
+                             struct spi_t *dev);
+
+/* l9733_fault_poll read the fault register and publish it, call from the
+ *     timer interrupt or polling thread.
+ * @return error status, ERR_L9733_BUS_BUSY if the poll preempted another
+ *     transfer on the controller and was skipped
+ */
+int l9733_fault_poll(struct l9733_fault_poller *poller);
+
+/* l9733_fault_poll_complete decode and publish a fault register that was
+ *     read by other means, e.g. from the DMA completion handler.
+ */
+void l9733_fault_poll_complete(struct l9733_fault_poller *poller,
+                               uint16_t faults);
+
+/* l9733_fault_snapshot copy the latest published state, never blocks.
+ *     The copy is only repeated if the poller published twice meanwhile.
+ */
+void l9733_fault_snapshot(const struct l9733_fault_poller *poller,
+                          struct l9733_fault_state *state);
+
+#endif /* SPI_L9733_H */